@@ -0,0 +1,147 @@
+#include "generators.hxx"
+
+#include "parser.hxx"
+
+
+namespace generators {
+
+namespace {
+
+constexpr size_t s_documentSize = 4 << 20;
+
+// Appends entries to the root section until the document has the size
+template <typename AppendEntry>
+std::string makeRoot(size_t size, AppendEntry appendEntry)
+{
+  std::string document = "{\n";
+  for (size_t i = 0; document.size() < size; ++i) {
+    if (i != 0) {
+      document += ",\n";
+    }
+    appendEntry(document, i);
+  }
+  document += "\n}\n";
+  return document;
+}
+
+void appendWide(std::string& document, size_t index)
+{
+  document += "  key_" + std::to_string(index) + ": \"value " +
+    std::to_string(index * 7919) + "\"";
+}
+
+// Chain of nested sections with an entry at every level
+void appendDeep(std::string& document, size_t index)
+{
+  size_t const depth = parsing::Parser::s_maxSectionDepth - 2;
+
+  document += "section_" + std::to_string(index) + ": {";
+  for (size_t level = 1; level != depth; ++level) {
+    document += "key: \"" + std::to_string(level) + "\", s: {";
+  }
+  document += "key: \"last\"";
+  document.append(depth, '}');
+}
+
+void appendLongValue(std::string& document, size_t index)
+{
+  size_t const valueSize = 64 << 10;
+
+  document += "  key_" + std::to_string(index) + ": \"";
+  for (size_t i = 0; i != valueSize; ++i) {
+    document += char('a' + (i * 7 + index) % 26);
+    if (i % 80 == 79) {
+      document += ' ';
+    }
+  }
+  document += '"';
+}
+
+void appendEscapes(std::string& document, size_t index)
+{
+  static char const* const escapes[] = {
+    "\\n", "\\r", "\\\\", "\\x0022", "\\x00e9", "\\x4e2d", "\\xd83d\\xde00"
+  };
+  size_t const escapeCount = 32;
+
+  document += "  key_" + std::to_string(index) + ": \"";
+  for (size_t i = 0; i != escapeCount; ++i) {
+    document += escapes[(i + index) % (sizeof(escapes) / sizeof(*escapes))];
+    document += char('a' + i % 26);
+  }
+  document += '"';
+}
+
+// Words of non-ASCII characters escaped as code points, like
+// machine-generated texts
+void appendEscapeRuns(std::string& document, size_t index)
+{
+  static char const* const characters[] = {
+    "\\x043f", "\\x0440", "\\x00e9", "\\x4e2d", "\\x6587",
+    "\\xd83d\\xde00"
+  };
+  size_t const characterCount = 48;
+
+  document += "  key_" + std::to_string(index) + ": \"";
+  for (size_t i = 0; i != characterCount; ++i) {
+    document +=
+      characters[(i + index) % (sizeof(characters) / sizeof(*characters))];
+    if (i % 8 == 7) {
+      document += ' ';
+    }
+  }
+  document += '"';
+}
+
+void appendUtf8(std::string& document, size_t index)
+{
+  // 2, 3 and 4-byte sequences
+  static char const* const characters[] = {
+    "\xD0\x96", "\xC3\xA9", "\xE4\xB8\xAD", "\xE6\x96\x87", "\xF0\x9F\x98\x80"
+  };
+  size_t const characterCount = 48;
+
+  document += "  key_" + std::to_string(index) + ": \"";
+  for (size_t i = 0; i != characterCount; ++i) {
+    document +=
+      characters[(i + index) % (sizeof(characters) / sizeof(*characters))];
+  }
+  document += '"';
+}
+
+} // namespace
+
+std::string makeDocument(Shape shape, size_t size)
+{
+  switch (shape) {
+    case Shape::Wide:
+      return makeRoot(size, appendWide);
+    case Shape::Deep:
+      return makeRoot(size, appendDeep);
+    case Shape::LongValues:
+      return makeRoot(size, appendLongValue);
+    case Shape::EscapeHeavy:
+      return makeRoot(size, appendEscapes);
+    case Shape::EscapeRuns:
+      return makeRoot(size, appendEscapeRuns);
+    case Shape::Utf8Heavy:
+      return makeRoot(size, appendUtf8);
+    // no default for warning
+  }
+  return std::string();
+}
+
+std::string const& getDocument(Shape shape)
+{
+  static std::string const documents[] = {
+    makeDocument(Shape::Wide, s_documentSize),
+    makeDocument(Shape::Deep, s_documentSize),
+    makeDocument(Shape::LongValues, s_documentSize),
+    makeDocument(Shape::EscapeHeavy, s_documentSize),
+    makeDocument(Shape::EscapeRuns, s_documentSize),
+    makeDocument(Shape::Utf8Heavy, s_documentSize)
+  };
+  return documents[static_cast<size_t>(shape)];
+}
+
+} // namespace generators
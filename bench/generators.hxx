@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+// Synthetic documents of different shapes for the benchmark suite.
+// Generated documents are deterministic and have about the given size.
+namespace generators {
+
+enum class Shape {
+  Wide, // one flat section with many short entries
+  Deep, // sections nested close to the depth limit
+  LongValues, // few entries with values of kilobytes
+  EscapeHeavy, // values made mostly of escape sequences
+  EscapeRuns, // values with all non-ASCII characters escaped
+  Utf8Heavy // values made mostly of multibyte UTF-8 characters
+};
+
+std::string makeDocument(Shape shape, size_t size);
+
+// Returns the cached document of the shape of several megabytes
+std::string const& getDocument(Shape shape);
+
+} // namespace generators
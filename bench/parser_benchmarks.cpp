@@ -0,0 +1,343 @@
+#include "benchmark/benchmark.h"
+
+#include "key_pool.hxx"
+#include "lazy_document.hxx"
+#include "parser.hxx"
+#include "projection.hxx"
+#include "snapshot.hxx"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+using namespace parsing;
+
+namespace {
+
+// Flat section with short keys and values, typical for configs
+std::string makeDocument(size_t entryCount)
+{
+  std::string document = "{\n";
+  for (size_t i = 0; i != entryCount; ++i) {
+    document += "  key_" + std::to_string(i) + ": \"value " +
+      std::to_string(i * 7919) + "\"";
+    document += (i + 1 != entryCount) ? ",\n" : "\n";
+  }
+  document += "}\n";
+  return document;
+}
+
+std::string const& getDocument()
+{
+  static std::string const document = makeDocument(10000);
+  return document;
+}
+
+std::string const& getLargeDocument()
+{
+  static std::string const document = makeDocument(500000);
+  return document;
+}
+
+// Every thread parses its own copy of the same document. With no shared
+// state in the lexer, the throughput should scale with the thread count.
+void BM_parseThreads(benchmark::State& state)
+{
+  std::string const document = getDocument();
+
+  for (auto _ : state) {
+    Parser parser(document.data(), document.size());
+    Parser::ParsingResult result = parser.parse();
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+// Single large document parsed by the given number of threads
+void BM_parseParallel(benchmark::State& state)
+{
+  std::string const& document = getLargeDocument();
+  size_t const threadCount = size_t(state.range(0));
+
+  for (auto _ : state) {
+    Parser::ParsingResult result =
+      Parser::parseParallel(document.data(), document.size(), threadCount);
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+std::vector<std::string> const& getSmallDocuments()
+{
+  static std::vector<std::string> const documents = [] {
+    std::vector<std::string> result;
+    for (size_t i = 0; i != 1000; ++i) {
+      result.push_back(makeDocument(20));
+    }
+    return result;
+  }();
+  return documents;
+}
+
+// Baseline for the batch parsing: a stream and a parser per document
+void BM_parseDocumentsSeparately(benchmark::State& state)
+{
+  std::vector<std::string> const& documents = getSmallDocuments();
+  int64_t bytes = 0;
+
+  for (auto _ : state) {
+    for (std::string const& document : documents) {
+      std::istringstream stream(document);
+      Parser parser(stream);
+      Parser::ParsingResult result = parser.parse();
+      benchmark::DoNotOptimize(result);
+      bytes += int64_t(document.size());
+    }
+  }
+
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(int64_t(state.iterations() * documents.size()));
+}
+
+void BM_parseBatch(benchmark::State& state)
+{
+  std::vector<std::string> const& documents = getSmallDocuments();
+  std::vector<TextView> const inputs(documents.begin(), documents.end());
+  size_t const threadCount = size_t(state.range(0));
+  int64_t bytes = 0;
+  for (std::string const& document : documents) {
+    bytes += int64_t(document.size());
+  }
+
+  for (auto _ : state) {
+    std::vector<Parser::ParsingResult> results =
+      Parser::parseBatch(inputs.data(), inputs.size(), threadCount);
+    benchmark::DoNotOptimize(results);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * bytes);
+  state.SetItemsProcessed(int64_t(state.iterations() * documents.size()));
+}
+
+// Latency of the first lookup in a large document: full parsing
+void BM_firstLookupParsed(benchmark::State& state)
+{
+  std::string const& document = getLargeDocument();
+
+  for (auto _ : state) {
+    Parser parser(document.data(), document.size());
+    Parser::ParsingResult result = parser.parse();
+    benchmark::DoNotOptimize(result.m_tree.find("key_250000"));
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+// Latency of the first lookup in a large document: structural index
+void BM_firstLookupLazy(benchmark::State& state)
+{
+  std::string const& document = getLargeDocument();
+
+  for (auto _ : state) {
+    LazyDocument lazyDocument;
+    lazyDocument.parse(document.data(), document.size());
+    benchmark::DoNotOptimize(lazyDocument.findPath("key_250000").getValue());
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+// Warm start from a snapshot of the large document: checking the image
+// and a lookup
+void BM_firstLookupSnapshot(benchmark::State& state)
+{
+  static std::string const image = [] {
+    std::string const& document = getLargeDocument();
+    Parser parser(document.data(), document.size());
+    return Snapshot::serialize(parser.parse().m_tree, 0);
+  }();
+
+  for (auto _ : state) {
+    Snapshot snapshot;
+    snapshot.open(image.data(), image.size());
+    TextView value;
+    benchmark::DoNotOptimize(snapshot.find("key_250000", value));
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * image.size());
+}
+
+// Latency of the first lookup in a large document: projection parsing
+void BM_firstLookupProjected(benchmark::State& state)
+{
+  std::string const& document = getLargeDocument();
+  Projection const projection = { "key_250000" };
+
+  for (auto _ : state) {
+    Parser::ParsingResult result =
+      Parser::parseProjection(document.data(), document.size(), projection);
+    benchmark::DoNotOptimize(result.m_tree.find("key_250000"));
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+// Several megabytes of sections with many entries
+std::string const& getSectionedDocument()
+{
+  static std::string const document = [] {
+    std::string result = "{\n";
+    for (size_t section = 0; section != 2000; ++section) {
+      result += "  section_" + std::to_string(section) + ": {\n";
+      for (size_t i = 0; i != 100; ++i) {
+        result += "    key_" + std::to_string(i) + ": \"value\\n" +
+          std::to_string(section * 7919 + i) + "\",\n";
+      }
+      result += "    nested: { a: \"{\", b: \"}\" }\n  },\n";
+    }
+    result += "  last: \"\"\n}\n";
+    return result;
+  }();
+  return document;
+}
+
+// Extraction of a few keys and a section from the sectioned document,
+// by parsing everything or only the selected entries
+void BM_extractKeys(benchmark::State& state, bool isProjected)
+{
+  std::string const& document = getSectionedDocument();
+  Projection const projection = {
+    "section_10:key_5", "section_500", "section_1000:key_50",
+    "section_1999:nested:a", "last"
+  };
+
+  for (auto _ : state) {
+    Parser::ParsingResult result;
+    if (isProjected) {
+      result = Parser::parseProjection(document.data(), document.size(),
+        projection);
+    } else {
+      Parser parser(document.data(), document.size());
+      result = parser.parse();
+    }
+    benchmark::DoNotOptimize(result.m_tree.find("section_1000:key_50"));
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+// Short malformed payloads with lexical errors, which are rejected
+// at the error position
+void BM_rejectMalformed(benchmark::State& state)
+{
+  static std::vector<std::string> const documents = {
+    "{ key: \"value\\q\" }",
+    "{ key: \"\\xD800\\x0041\" }",
+    "{ ke\x05y: \"value\" }",
+    "{ key: \"val\x01ue\" }",
+    "{ key: \"value"
+  };
+
+  for (auto _ : state) {
+    for (std::string const& document : documents) {
+      Parser parser(document.data(), document.size());
+      Parser::ParsingResult result = parser.parse();
+      benchmark::DoNotOptimize(result);
+    }
+  }
+
+  state.SetItemsProcessed(int64_t(state.iterations()) * documents.size());
+}
+
+// Config of service sections with the same entries, so the joined keys
+// are long and repeat between the documents
+std::string const& getConfigDocument()
+{
+  static std::string const document = [] {
+    static char const* const entries[] = {
+      "connection_timeout_ms", "max_pool_size", "retry_policy",
+      "endpoint_address", "log_level", "enable_compression"
+    };
+
+    std::string result = "{\n";
+    for (size_t i = 0; i != 100; ++i) {
+      result += "  service_" + std::to_string(i) + ": {\n";
+      for (char const* entry : entries) {
+        result += "    " + std::string(entry) + ": \"" +
+          std::to_string(i * 7919) + "\",\n";
+      }
+      result += "    limits: { requests_per_second: \"100\" }\n  },\n";
+    }
+    result += "  version: \"1\"\n}\n";
+    return result;
+  }();
+  return document;
+}
+
+// Parsing of one of many resident configs with the same keys. The heap
+// memory of the tree of a document is measured after the timing. The
+// pool is shared by the documents, so its size is reported once.
+void BM_parseResident(benchmark::State& state, bool isInterned)
+{
+  std::string const& document = getConfigDocument();
+  KeyPool pool;
+
+  for (auto _ : state) {
+    Parser parser(document.data(), document.size());
+    if (isInterned) {
+      Parser::InternedParsingResult result = parser.parse(pool);
+      benchmark::DoNotOptimize(result);
+    } else {
+      Parser::ParsingResult result = parser.parse();
+      benchmark::DoNotOptimize(result);
+    }
+  }
+
+  Parser parser(document.data(), document.size());
+  TreeMemory const memory = isInterned ?
+    measureTreeMemory(parser.parse(pool).m_tree) :
+    measureTreeMemory(parser.parse().m_tree);
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+  state.counters["tree_bytes"] = double(memory.m_allocatedBytes);
+  state.counters["tree_allocations"] = double(memory.m_allocationCount);
+  state.counters["pool_bytes"] = double(pool.getStats().m_reservedBytes);
+}
+
+// Threads parse copies of the config with the keys interned in the same
+// pool, so all of them look up the same keys
+void BM_parseInternedThreads(benchmark::State& state)
+{
+  static KeyPool pool;
+  std::string const document = getConfigDocument();
+
+  for (auto _ : state) {
+    Parser parser(document.data(), document.size());
+    Parser::InternedParsingResult result = parser.parse(pool);
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_parseThreads)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_parseParallel)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+BENCHMARK(BM_parseDocumentsSeparately)->UseRealTime();
+BENCHMARK(BM_parseBatch)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+BENCHMARK(BM_firstLookupParsed)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_firstLookupLazy)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_firstLookupSnapshot)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_firstLookupProjected)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_rejectMalformed);
+BENCHMARK_CAPTURE(BM_parseResident, strings, false);
+BENCHMARK_CAPTURE(BM_parseResident, interned, true);
+BENCHMARK_CAPTURE(BM_extractKeys, parsed, false)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_extractKeys, projected, true)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_parseInternedThreads)->ThreadRange(1, 32)->UseRealTime();
@@ -0,0 +1,212 @@
+#include "benchmark/benchmark.h"
+
+#include "scanning.hxx"
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PARSING_HAS_RDTSC 1
+#else
+#define PARSING_HAS_RDTSC 0
+#endif
+
+
+using namespace parsing;
+
+namespace {
+
+using ScanFunction = char const* (*)(char const*, char const*);
+
+// Runs the kernel over the whole input and reports bytes per second
+// and bytes per (reference) cycle
+void runScan(benchmark::State& state, ScanFunction kernel,
+  std::string const& input)
+{
+  char const* const begin = input.data();
+  char const* const end = begin + input.size();
+
+#if PARSING_HAS_RDTSC
+  unsigned long long cycles = 0;
+#endif
+  for (auto _ : state) {
+#if PARSING_HAS_RDTSC
+    unsigned long long const start = __rdtsc();
+#endif
+    char const* result = kernel(begin, end);
+    benchmark::DoNotOptimize(result);
+#if PARSING_HAS_RDTSC
+    cycles += __rdtsc() - start;
+#endif
+  }
+
+  int64_t const bytes = int64_t(state.iterations()) * input.size();
+  state.SetBytesProcessed(bytes);
+#if PARSING_HAS_RDTSC
+  state.counters["bytes_per_cycle"] = double(bytes) / double(cycles);
+#endif
+}
+
+std::string makeValueBody(size_t size)
+{
+  std::string body;
+  body.reserve(size + 1);
+  for (size_t i = 0; i != size; ++i) {
+    body.push_back(char('A' + i % 26));
+  }
+  body.push_back('"');
+  return body;
+}
+
+std::string makeWhitespace(size_t size)
+{
+  std::string whitespace;
+  whitespace.reserve(size + 1);
+  for (size_t i = 0; i != size; ++i) {
+    whitespace.push_back((i % 8 == 0) ? '\n' : ' ');
+  }
+  whitespace.push_back('k');
+  return whitespace;
+}
+
+// Words of 2 and 3-byte characters separated by spaces
+std::string makeMultibyteText(size_t size)
+{
+  static char const* const words[] = {
+    "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82",
+    "\xE4\xB8\xAD\xE6\x96\x87",
+    "text"
+  };
+
+  std::string text;
+  for (size_t i = 0; text.size() < size; ++i) {
+    text += words[i % 3];
+    text += ' ';
+  }
+  text.resize(size, ' ');
+  return text;
+}
+
+// Escaped non-ASCII characters, including surrogate pairs
+std::string makeEscapeRun(size_t size)
+{
+  static char const* const sequences[] = {
+    "\\x043f", "\\x00e9", "\\x4e2d", "\\xd83d\\xde00", "\\n"
+  };
+
+  std::string text;
+  for (size_t i = 0; text.size() < size; ++i) {
+    text += sequences[i % 5];
+  }
+  return text;
+}
+
+// Nested sections of short entries with braces in values, closed
+// at the end
+std::string makeSectionBody(size_t size)
+{
+  static char const* const entries[] = {
+    "key: \"value\", ", "inner: { a: \"{\", b: \"}}\" }, ",
+    "text: \"some longer value of the entry\",\n"
+  };
+
+  std::string body;
+  for (size_t i = 0; body.size() < size; ++i) {
+    body += entries[i % 3];
+  }
+  body.push_back('}');
+  return body;
+}
+
+void BM_findValueSpecial(benchmark::State& state, ScanFunction kernel)
+{
+  runScan(state, kernel, makeValueBody(state.range(0)));
+}
+
+void BM_skipIgnored(benchmark::State& state, ScanFunction kernel)
+{
+  runScan(state, kernel, makeWhitespace(state.range(0)));
+}
+
+void BM_findInvalidUtf8(benchmark::State& state, ScanFunction kernel)
+{
+  runScan(state, kernel, makeMultibyteText(state.range(0)));
+}
+
+void BM_skipSection(benchmark::State& state, ScanFunction kernel)
+{
+  runScan(state, kernel, makeSectionBody(state.range(0)));
+}
+
+void BM_decodeEscapes(benchmark::State& state)
+{
+  std::string const input = makeEscapeRun(state.range(0));
+  std::string output(input.size(), '\0');
+  char const* const begin = input.data();
+  char const* const end = begin + input.size();
+
+  for (auto _ : state) {
+    scanning::DecodedEscapes const result =
+      scanning::decodeEscapes(begin, end, &output[0]);
+    benchmark::DoNotOptimize(result);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * input.size());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_findValueSpecial, scalar,
+  scanning::scalar::findValueSpecial)->Range(16, 64 << 10);
+BENCHMARK_CAPTURE(BM_findValueSpecial, dispatched,
+  scanning::findValueSpecial)->Range(16, 64 << 10);
+#if PARSING_HAS_SSE2
+BENCHMARK_CAPTURE(BM_findValueSpecial, sse2,
+  scanning::sse2::findValueSpecial)->Range(16, 64 << 10);
+#endif
+#if PARSING_HAS_AVX2
+BENCHMARK_CAPTURE(BM_findValueSpecial, avx2,
+  scanning::avx2::findValueSpecial)->Range(16, 64 << 10);
+#endif
+
+BENCHMARK_CAPTURE(BM_skipIgnored, scalar,
+  scanning::scalar::skipIgnored)->Range(16, 64 << 10);
+BENCHMARK_CAPTURE(BM_skipIgnored, dispatched,
+  scanning::skipIgnored)->Range(16, 64 << 10);
+#if PARSING_HAS_SSE2
+BENCHMARK_CAPTURE(BM_skipIgnored, sse2,
+  scanning::sse2::skipIgnored)->Range(16, 64 << 10);
+#endif
+#if PARSING_HAS_AVX2
+BENCHMARK_CAPTURE(BM_skipIgnored, avx2,
+  scanning::avx2::skipIgnored)->Range(16, 64 << 10);
+#endif
+
+BENCHMARK_CAPTURE(BM_findInvalidUtf8, scalar,
+  scanning::scalar::findInvalidUtf8)->Range(16, 64 << 10);
+BENCHMARK_CAPTURE(BM_findInvalidUtf8, dispatched,
+  scanning::findInvalidUtf8)->Range(16, 64 << 10);
+#if PARSING_HAS_SSE2
+BENCHMARK_CAPTURE(BM_findInvalidUtf8, sse2,
+  scanning::sse2::findInvalidUtf8)->Range(16, 64 << 10);
+#endif
+#if PARSING_HAS_AVX2
+BENCHMARK_CAPTURE(BM_findInvalidUtf8, avx2,
+  scanning::avx2::findInvalidUtf8)->Range(16, 64 << 10);
+#endif
+
+BENCHMARK_CAPTURE(BM_skipSection, scalar,
+  scanning::scalar::skipSection)->Range(16, 64 << 10);
+BENCHMARK_CAPTURE(BM_skipSection, dispatched,
+  scanning::skipSection)->Range(16, 64 << 10);
+#if PARSING_HAS_SSE2
+BENCHMARK_CAPTURE(BM_skipSection, sse2,
+  scanning::sse2::skipSection)->Range(16, 64 << 10);
+#endif
+#if PARSING_HAS_AVX2
+BENCHMARK_CAPTURE(BM_skipSection, avx2,
+  scanning::avx2::skipSection)->Range(16, 64 << 10);
+#endif
+
+BENCHMARK(BM_decodeEscapes)->Range(16, 64 << 10);
@@ -0,0 +1,209 @@
+#include "benchmark/benchmark.h"
+
+#include "generators.hxx"
+#include "parser.hxx"
+#include "writer.hxx"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+
+using namespace parsing;
+using generators::Shape;
+
+namespace {
+
+// Returns the number of tokens in the document, or 0 on a lexing error
+size_t lexDocument(std::string const& document)
+{
+  Lexer lexer(document.data(), document.size());
+  size_t tokenCount = 0;
+  for (TokenKind kind = lexer.getCurrent().getKind();
+      kind != TokenKind::ParseEnd; kind = lexer.getNext().getKind())
+  {
+    if (kind == TokenKind::ParseError) {
+      return 0;
+    }
+    ++tokenCount;
+  }
+  return tokenCount;
+}
+
+size_t getTokenCount(Shape shape)
+{
+  static size_t const counts[] = {
+    lexDocument(generators::getDocument(Shape::Wide)),
+    lexDocument(generators::getDocument(Shape::Deep)),
+    lexDocument(generators::getDocument(Shape::LongValues)),
+    lexDocument(generators::getDocument(Shape::EscapeHeavy)),
+    lexDocument(generators::getDocument(Shape::EscapeRuns)),
+    lexDocument(generators::getDocument(Shape::Utf8Heavy))
+  };
+  return counts[static_cast<size_t>(shape)];
+}
+
+// Reports MB/s and tokens/s of the processed documents
+void setThroughput(benchmark::State& state, Shape shape)
+{
+  std::string const& document = generators::getDocument(shape);
+  state.SetBytesProcessed(int64_t(state.iterations()) * document.size());
+  state.counters["tokens"] = benchmark::Counter(
+    double(state.iterations()) * double(getTokenCount(shape)),
+    benchmark::Counter::kIsRate);
+}
+
+void BM_lex(benchmark::State& state, Shape shape)
+{
+  std::string const& document = generators::getDocument(shape);
+  if (getTokenCount(shape) == 0) {
+    state.SkipWithError("invalid document");
+    return;
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lexDocument(document));
+  }
+
+  setThroughput(state, shape);
+}
+
+void BM_parseToTree(benchmark::State& state, Shape shape)
+{
+  std::string const& document = generators::getDocument(shape);
+
+  for (auto _ : state) {
+    Parser parser(document.data(), document.size());
+    Parser::ParsingResult result = parser.parse();
+    if (!result.m_success) {
+      state.SkipWithError("parsing failed");
+      return;
+    }
+    benchmark::DoNotOptimize(result);
+  }
+
+  setThroughput(state, shape);
+}
+
+// Same as the above, with UTF-8 validation of values
+void BM_parseToTreeValidated(benchmark::State& state, Shape shape)
+{
+  std::string const& document = generators::getDocument(shape);
+
+  for (auto _ : state) {
+    Parser parser(document.data(), document.size());
+    parser.setUtf8Validation(true);
+    Parser::ParsingResult result = parser.parse();
+    if (!result.m_success) {
+      state.SkipWithError("parsing failed");
+      return;
+    }
+    benchmark::DoNotOptimize(result);
+  }
+
+  setThroughput(state, shape);
+}
+
+// The file is written once and then is in the page cache, so the time
+// includes the file opening and mapping, but not the disk reading
+void BM_parseFile(benchmark::State& state, Shape shape)
+{
+  std::string const& document = generators::getDocument(shape);
+  std::string const path = "benchmark_document_" +
+    std::to_string(static_cast<int>(shape)) + ".txt";
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(document.data(), std::streamsize(document.size()));
+  }
+
+  for (auto _ : state) {
+    Parser::ParsingResult result = Parser::parseFile(path);
+    if (!result.m_success) {
+      state.SkipWithError("parsing failed");
+      break;
+    }
+    benchmark::DoNotOptimize(result);
+  }
+
+  std::remove(path.c_str());
+  setThroughput(state, shape);
+}
+
+// Writes the parsed document to a reused buffer, the bytes are
+// of the output
+void BM_write(benchmark::State& state, Shape shape, WritingStyle style)
+{
+  std::string const& document = generators::getDocument(shape);
+  Parser parser(document.data(), document.size());
+  Parser::ParsingResult const result = parser.parse();
+  if (!result.m_success) {
+    state.SkipWithError("parsing failed");
+    return;
+  }
+
+  Writer const writer(style);
+  std::string output;
+  for (auto _ : state) {
+    output.clear();
+    writer.write(result.m_tree, output);
+    benchmark::DoNotOptimize(output.data());
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * output.size());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_lex, wide, Shape::Wide);
+BENCHMARK_CAPTURE(BM_lex, deep, Shape::Deep);
+BENCHMARK_CAPTURE(BM_lex, long_values, Shape::LongValues);
+BENCHMARK_CAPTURE(BM_lex, escape_heavy, Shape::EscapeHeavy);
+BENCHMARK_CAPTURE(BM_lex, escape_runs, Shape::EscapeRuns);
+BENCHMARK_CAPTURE(BM_lex, utf8_heavy, Shape::Utf8Heavy);
+
+BENCHMARK_CAPTURE(BM_parseToTree, wide, Shape::Wide);
+BENCHMARK_CAPTURE(BM_parseToTree, deep, Shape::Deep);
+BENCHMARK_CAPTURE(BM_parseToTree, long_values, Shape::LongValues);
+BENCHMARK_CAPTURE(BM_parseToTree, escape_heavy, Shape::EscapeHeavy);
+BENCHMARK_CAPTURE(BM_parseToTree, escape_runs, Shape::EscapeRuns);
+BENCHMARK_CAPTURE(BM_parseToTree, utf8_heavy, Shape::Utf8Heavy);
+
+BENCHMARK_CAPTURE(BM_parseToTreeValidated, wide, Shape::Wide);
+BENCHMARK_CAPTURE(BM_parseToTreeValidated, deep, Shape::Deep);
+BENCHMARK_CAPTURE(BM_parseToTreeValidated, long_values, Shape::LongValues);
+BENCHMARK_CAPTURE(BM_parseToTreeValidated, escape_heavy, Shape::EscapeHeavy);
+BENCHMARK_CAPTURE(BM_parseToTreeValidated, escape_runs, Shape::EscapeRuns);
+BENCHMARK_CAPTURE(BM_parseToTreeValidated, utf8_heavy, Shape::Utf8Heavy);
+
+BENCHMARK_CAPTURE(BM_parseFile, wide, Shape::Wide);
+BENCHMARK_CAPTURE(BM_parseFile, deep, Shape::Deep);
+BENCHMARK_CAPTURE(BM_parseFile, long_values, Shape::LongValues);
+BENCHMARK_CAPTURE(BM_parseFile, escape_heavy, Shape::EscapeHeavy);
+BENCHMARK_CAPTURE(BM_parseFile, escape_runs, Shape::EscapeRuns);
+BENCHMARK_CAPTURE(BM_parseFile, utf8_heavy, Shape::Utf8Heavy);
+
+BENCHMARK_CAPTURE(BM_write, wide_compact, Shape::Wide,
+  WritingStyle::Compact);
+BENCHMARK_CAPTURE(BM_write, deep_compact, Shape::Deep,
+  WritingStyle::Compact);
+BENCHMARK_CAPTURE(BM_write, long_values_compact, Shape::LongValues,
+  WritingStyle::Compact);
+BENCHMARK_CAPTURE(BM_write, escape_heavy_compact, Shape::EscapeHeavy,
+  WritingStyle::Compact);
+BENCHMARK_CAPTURE(BM_write, escape_runs_compact, Shape::EscapeRuns,
+  WritingStyle::Compact);
+BENCHMARK_CAPTURE(BM_write, utf8_heavy_compact, Shape::Utf8Heavy,
+  WritingStyle::Compact);
+
+BENCHMARK_CAPTURE(BM_write, wide_pretty, Shape::Wide,
+  WritingStyle::Pretty);
+BENCHMARK_CAPTURE(BM_write, deep_pretty, Shape::Deep,
+  WritingStyle::Pretty);
+BENCHMARK_CAPTURE(BM_write, long_values_pretty, Shape::LongValues,
+  WritingStyle::Pretty);
+BENCHMARK_CAPTURE(BM_write, escape_heavy_pretty, Shape::EscapeHeavy,
+  WritingStyle::Pretty);
+BENCHMARK_CAPTURE(BM_write, escape_runs_pretty, Shape::EscapeRuns,
+  WritingStyle::Pretty);
+BENCHMARK_CAPTURE(BM_write, utf8_heavy_pretty, Shape::Utf8Heavy,
+  WritingStyle::Pretty);
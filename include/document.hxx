@@ -0,0 +1,117 @@
+#pragma once
+
+#include "parser.hxx"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+namespace parsing {
+
+// Bump allocator. Memory is given out from large blocks and is released
+// all at once, when the arena is cleared or destroyed. Objects created
+// in the arena are never destroyed, so they must be trivially destructible.
+class Arena {
+public:
+  explicit Arena(size_t blockSize = s_defaultBlockSize);
+
+  Arena(Arena&& other) noexcept;
+  Arena& operator = (Arena&& other) noexcept;
+
+  void* allocate(size_t size, size_t alignment);
+
+  template <class T>
+  T* allocateArray(size_t count)
+  {
+    return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  // Copies the text to the arena
+  TextView copyText(TextView text);
+
+  // Releases all the memory given out
+  void clear();
+
+  // Returns the total size of the blocks obtained from the system
+  size_t getReservedSize() const;
+
+  static constexpr size_t s_defaultBlockSize = 64 * 1024;
+
+private:
+  std::vector<std::unique_ptr<char[]>> m_blocks;
+  size_t m_reservedSize;
+  size_t m_blockSize;
+  char* m_current;
+  char* m_end;
+};
+
+// Node of a parsed document: either an entry with a text value,
+// or a section with child nodes.
+class DocumentNode {
+public:
+  using const_iterator = DocumentNode const* const*;
+
+  TextView getKey() const;
+
+  // Returns the entry value; sections have empty values
+  TextView getValue() const;
+
+  bool isSection() const;
+
+  // Children are ordered by key. Entries with equal keys keep
+  // the document order.
+  size_t getChildCount() const;
+  DocumentNode const& getChild(size_t index) const;
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  // Finds a child by key. If there are several such children,
+  // the first one in the document is returned. Returns null if
+  // there is no such child.
+  DocumentNode const* find(TextView key) const;
+
+  // Finds a descendant by the keys separated with
+  // Parser::s_categorySeparator, like "section:subsection:key".
+  DocumentNode const* findPath(TextView path) const;
+
+private:
+  friend class Document;
+
+  TextView m_key;
+  TextView m_value;
+  bool m_isSection;
+  DocumentNode const** m_children;
+  size_t m_childCount;
+};
+
+// Hierarchical parsing result. All nodes and texts are allocated in
+// a single arena owned by the document.
+class Document {
+public:
+  Document();
+
+  Document(Document&& other) noexcept;
+  Document& operator = (Document&& other) noexcept;
+
+  // Parses the input and replaces the document contents. On failure
+  // the document is left empty.
+  Parser::ParsingResult parse(Parser& parser);
+
+  DocumentNode const& getRoot() const;
+
+  // Finds a node by the path like "section:subsection:key"
+  DocumentNode const* findPath(TextView path) const;
+
+  Arena const& getArena() const;
+
+  void clear();
+
+private:
+  class Builder;
+
+  Arena m_arena;
+  DocumentNode const* m_root;
+};
+
+} // namespace parsing
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "parser.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace parsing {
+
+// Pool of interned keys, shared by parsers of many documents.
+//
+// Every distinct key is stored once, and trees parsed with the pool
+// reference keys by handles, so comparing keys is comparing handles.
+// Keys are never removed, so handles stay valid while the pool exists.
+//
+// The pool may be used from several threads at once. Keys are spread
+// over shards by hash, each with its own lock, so threads interning
+// different keys rarely wait for each other. Reading the key of
+// a handle takes no lock.
+class KeyPool {
+public:
+  struct Stats {
+    size_t m_keyCount = 0;
+    size_t m_keyBytes = 0; // total size of the key texts
+    size_t m_reservedBytes = 0; // texts, hash tables and handle tables
+  };
+
+  KeyPool();
+  ~KeyPool();
+
+  KeyPool(KeyPool const&) = delete;
+  KeyPool& operator = (KeyPool const&) = delete;
+
+  // Returns the handle of the key, adding the key if it is new.
+  // Throws std::length_error when a shard is out of handles.
+  KeyHandle intern(TextView key);
+
+  // Finds the handle of the key without adding it. Returns false
+  // if there is no such key.
+  bool find(TextView key, KeyHandle& handle) const;
+
+  // Returns the text of the key, which lives as long as the pool
+  TextView getKey(KeyHandle handle) const;
+
+  Stats getStats() const;
+
+private:
+  class Shard;
+
+  static constexpr uint32_t s_shardBits = 4;
+  static constexpr uint32_t s_shardCount = 1 << s_shardBits;
+
+  // Handles keep the key index of a shard above the shard bits
+  static constexpr uint32_t s_maxShardKeys = uint32_t(1) << (32 - s_shardBits);
+
+  std::unique_ptr<Shard[]> m_shards;
+};
+
+// Heap memory taken by a parsed tree
+struct TreeMemory {
+  size_t m_allocationCount = 0;
+  size_t m_allocatedBytes = 0;
+};
+
+// Measures the heap memory of the tree by building its copy with
+// a counting allocator. The copy has the node layout and the string
+// capacities of the tree, so its allocations are the ones of the tree.
+// Keys of interned trees are kept by the pool and are not included.
+TreeMemory measureTreeMemory(Parser::ParsedTree const& tree);
+TreeMemory measureTreeMemory(Parser::InternedTree const& tree);
+
+} // namespace parsing
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "document.hxx"
+#include "parser.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace parsing {
+
+class LazyDocument;
+
+// Handle of a lazily decoded document node. Handles are cheap to copy
+// and stay valid while the document is not changed. A null handle
+// is returned when a node is not found.
+class LazyNode {
+public:
+  LazyNode();
+
+  explicit operator bool() const;
+
+  TextView getKey() const;
+
+  // Returns the entry value, decoding it on the first access.
+  // Sections have empty values.
+  TextView getValue() const;
+
+  bool isSection() const;
+
+  // Children are visited in the document order
+  size_t getChildCount() const;
+  LazyNode getFirstChild() const;
+  LazyNode getNextSibling() const;
+
+  // Finds a child by key with a linear scan. If there are several
+  // such children, the first one in the document is returned.
+  LazyNode find(TextView key) const;
+
+  // Finds a descendant by the keys separated with
+  // Parser::s_categorySeparator, like "section:subsection:key".
+  LazyNode findPath(TextView path) const;
+
+private:
+  friend class LazyDocument;
+
+  LazyNode(LazyDocument const* document, uint32_t index);
+
+  LazyDocument const* m_document;
+  uint32_t m_index;
+};
+
+// Document backed by a structural index of in-memory data. Parsing only
+// checks the input and records the key and value positions. Keys are
+// referenced in the input, values are decoded when first accessed.
+// Decoded values are cached, so the document must not be accessed
+// from several threads at once.
+class LazyDocument {
+public:
+  LazyDocument();
+
+  LazyDocument(LazyDocument&& other) noexcept;
+  LazyDocument& operator = (LazyDocument&& other) noexcept;
+
+  // Indexes the data and replaces the document contents. The data
+  // must outlive the document. Inputs are accepted the same way as
+  // by Parser. On failure the document is left empty. Inputs larger
+  // than 4 GiB are not supported and fail with InputTooLarge.
+  Parser::ParsingResult parse(char const* data, size_t size);
+
+  LazyNode getRoot() const;
+
+  // Finds a node by the path like "section:subsection:key"
+  LazyNode findPath(TextView path) const;
+
+  // Returns the number of indexed nodes, including the root
+  size_t getNodeCount() const;
+
+  void clear();
+
+private:
+  friend class LazyNode;
+
+  enum Flags : uint8_t {
+    Section = 1 << 0,
+    Escaped = 1 << 1 // the value has escape sequences
+  };
+
+  struct Node {
+    uint32_t m_key; // offset of the key
+    uint32_t m_keySize;
+    uint32_t m_value; // offset of the value text after the quote
+    uint32_t m_valueSize; // text size of values, child count of sections
+    uint32_t m_next; // index of the next sibling, 0 for the last child
+    uint8_t m_flags;
+  };
+
+  static bool buildIndex(char const* data, size_t size,
+    std::vector<Node>& nodes);
+
+  char const* m_data;
+  std::vector<Node> m_nodes;
+
+  mutable Arena m_arena; // decoded values
+  mutable std::unordered_map<uint32_t, TextView> m_values;
+};
+
+} // namespace parsing
@@ -1,8 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <exception>
+#include <ostream>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+#if defined(PARSER_WITH_PMR)
+#include <memory_resource>
+#endif
 
+#if defined(PARSER_WITH_STATS)
+#include <array>
+#include <chrono>
+#endif
 
 namespace parsing {
 
@@ -17,7 +32,7 @@ namespace parsing {
 //
 // key = [a-zA-Z0-9_]+
 // entry = entry_key ':' ( value | section )
-// entries = entry ( ',' entry )?
+// entries = entry ( ',' entry )*
 // section = '{' ( entries )? '}'
 // S = (UTF-8 BOM)? section
 //
@@ -45,15 +60,62 @@ enum class TokenKind : int {
   ParseError
 };
 
+// Non-owning reference to a sequence of characters.
+class TextView {
+public:
+  using const_iterator = char const*;
+
+  TextView();
+  TextView(char const* data, size_t size);
+  TextView(std::string const& text);
+  TextView(char const* text);
+
+  char const* getData() const;
+  size_t getSize() const;
+  bool isEmpty() const;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  std::string toString() const;
+
+  friend bool operator == (TextView const& a, TextView const& b);
+  friend bool operator != (TextView const& a, TextView const& b);
+  friend bool operator < (TextView const& a, TextView const& b);
+
+  friend bool operator == (std::string const& a, TextView const& b);
+  friend bool operator == (TextView const& a, std::string const& b);
+
+  friend std::ostream& operator << (std::ostream& os, TextView const& text);
+
+private:
+  char const* m_data;
+  size_t m_size;
+};
+
+// Handle of a key interned in a KeyPool. Handles of the same pool
+// are equal only if their keys are equal.
+enum class KeyHandle : uint32_t {};
+
+class KeyPool;
+class Projection;
+
+// Lexical token. The token text either references the lexer input
+// (when lexing from a buffer and no decoding was needed) or is owned
+// by the token itself.
 class Token {
 public:
-  using ValueType = std::string;
+  using ValueType = TextView;
 
   Token();
-  Token(TokenKind kind, std::string const& value);
+  Token(TokenKind kind, std::string value);
+  Token(TokenKind kind, TextView value);
 
   TokenKind const& getKind() const;
-  ValueType const& getText() const;
+  ValueType getText() const;
+
+  // Checks if the token text is stored in the token
+  bool isOwning() const;
 
   operator bool() const;
 
@@ -64,14 +126,53 @@ public:
   friend bool operator == (TokenKind const& a, Token const& b);
 
 private:
+  friend class Lexer;
+
   TokenKind m_kind;
-  ValueType m_value;
+  bool m_owning;
+  TextView m_view;
+  std::string m_storage;
+};
+
+// Reason of the ParseError token
+enum class LexingErrorKind {
+  None = 0,
+  UnexpectedDataEnd,
+  InputReadError,
+  WrongBom,
+  UnexpectedSymbol, // no token starts with the symbol
+  UnexpectedKeySymbol,
+  UnexpectedValueSymbol,
+  UnknownEscapeSequence,
+  WrongEscapeSequence,
+  ExpectedLowSurrogate,
+  WrongLowSurrogate,
+  InvalidUtf8
 };
 
+// Lexical errors are returned as ParseError tokens with no exceptions
+// thrown. The token text is a short static error description.
 class Lexer {
 public:
+  // Lexes the stream contents. The stream is read by large chunks,
+  // so it may be read past the last token. The stream is never
+  // sought, which allows to read from pipes and sockets.
   Lexer(std::istream& is);
 
+  // Lexes contiguous in-memory data. The data must outlive the lexer.
+  Lexer(char const* data, size_t size);
+
+  // Restarts lexing of new in-memory data. Buffers allocated
+  // for the previous input are reused. Token positions are counted
+  // from the offset, when the data is a part of a larger input.
+  // With a non-zero offset, the data continues the previous one,
+  // so the line numbering continues as well.
+  void reset(char const* data, size_t size, size_t offset = 0);
+
+  // Enables validation of UTF-8 in values. Invalid values are lexed
+  // as ParseError tokens. Disabled by default.
+  void setUtf8Validation(bool enabled);
+
   Token const& getCurrent();
   Token const& getNext();
 
@@ -79,25 +180,114 @@ public:
 
   std::istream::pos_type getPosition() const;
 
+  // Line and column of the position, starting from 1. Columns are
+  // counted in bytes. Lines are tracked while skipping whitespace,
+  // so tokens are read with no extra work.
+  size_t getLine() const;
+  size_t getColumn() const;
+
+  // Returns the error of the last ParseError token
+  LexingErrorKind getErrorKind() const;
+
+  // Makes the error message with the error position. The message
+  // is empty if there was no error.
+  std::string getErrorMessage() const;
+
 private:
   class impl;
 
+  // Characters are checked before reading. The end of data is read
+  // as the end of file character.
   char getChar();
-  char peekChar() const;
+  char peekChar();
+
+  // Input is scanned in the [m_begin; m_end) window. The window covers
+  // either the whole in-memory buffer, or the current stream chunk.
+  // The stream pointer is null when lexing from the buffer.
+  std::istream* m_stream;
+  std::vector<char> m_chunk;
+  size_t m_offset; // position of the window begin in the input
+  char const* m_begin;
+  char const* m_current;
+  char const* m_end;
 
-  std::istream& m_stream;
   Token m_lastToken;
+  std::string m_buffer; // recycled storage for token texts
+
+  LexingErrorKind m_error;
+  std::istream::pos_type m_errorPosition;
+
+  size_t m_line; // current line number
+  size_t m_lineBegin; // position of the current line begin in the input
+
+  bool m_validateUtf8;
 };
 
 
 enum class ParsingErrorKind {
   UnexpectedTokenReceived,
-  UnexpectedDataEnd
+  UnexpectedDataEnd,
+  InputReadError,
+  NestingTooDeep,
+  InputTooLarge, // the input size is out of the supported range
+  InternalError // a library bug, never expected
 };
 
 struct ParsingError {
   ParsingErrorKind m_kind;
   std::istream::pos_type m_position;
+
+  // Line and column of the position, starting from 1. Columns are
+  // counted in bytes. Both are 0 if the input was not read.
+  size_t m_line;
+  size_t m_column;
+};
+
+#if defined(PARSER_WITH_STATS)
+// Parsing statistics, collected when the library is built
+// with PARSER_WITH_STATS.
+//
+// Lexing and parsing are interleaved, so the phase times are sums
+// of the time spent in each phase while reading the tokens. The total
+// time is the wall-clock time of the parsing call. Chunks of parallel
+// parsing run at once, so their phase times are scaled to the wall-clock
+// time of the chunk parsing. Projection parsing reads the tokens
+// of the selected entries only.
+//
+// Allocations are not counted: the trees use the standard allocator,
+// their heap memory is measured by measureTreeMemory() of key_pool.hxx.
+struct ParsingStats {
+  using Duration = std::chrono::nanoseconds;
+
+  size_t m_bytes = 0; // input bytes consumed
+
+  // Tokens read, indexed by TokenKind. The token which failed
+  // the parsing is counted as well.
+  std::array<size_t, size_t(TokenKind::ParseError) + 1> m_tokenCounts = {};
+
+  size_t m_maxDepth = 0; // maximum section nesting, including the root
+
+  Duration m_lexingTime = Duration::zero();
+  Duration m_parsingTime = Duration::zero(); // the parser state machine
+  Duration m_handlingTime = Duration::zero(); // handler calls, tree building
+  Duration m_totalTime = Duration::zero();
+};
+#endif // PARSER_WITH_STATS
+
+// Receives parsing events in the document order.
+//
+// Texts passed to the handler are valid only during the call.
+// If parsing fails, the events received so far are not rolled back.
+class ParsingHandler {
+public:
+  virtual ~ParsingHandler() = default;
+
+  // Called when a section begins. The key is empty for the root section.
+  virtual void onSectionBegin(TextView key) = 0;
+  virtual void onSectionEnd() = 0;
+
+  // Called for each entry with a text value
+  virtual void onEntry(TextView key, TextView value) = 0;
 };
 
 class Parser {
@@ -112,18 +302,144 @@ public:
 
     ParsedTree m_tree;
     ParsingError m_error;
+
+#if defined(PARSER_WITH_STATS)
+    ParsingStats m_stats;
+#endif
   };
 
   Parser(std::istream& is);
 
+  // Parses contiguous in-memory data. The data must outlive the parser.
+  Parser(char const* data, size_t size);
+
+  // Restarts parsing of new in-memory data. Buffers allocated
+  // for the previous input are reused.
+  void reset(char const* data, size_t size);
+
+  // Enables validation of UTF-8 in values for the next parsing.
+  // Overlong forms, surrogates, code points above U+10FFFF and
+  // truncated sequences are rejected. Disabled by default.
+  void setUtf8Validation(bool enabled);
+
   ParsingResult parse();
 
+  // Parses the input and reports the parsed data to the handler
+  // as it is produced. The resulting tree is not built.
+  ParsingResult parse(ParsingHandler& handler);
+
+  // Tree with the keys interned in a KeyPool, ordered by handle
+  using InternedTree = std::map<KeyHandle, Value>;
+
+  struct InternedParsingResult {
+    bool m_success;
+
+    InternedTree m_tree;
+    ParsingError m_error;
+
+#if defined(PARSER_WITH_STATS)
+    ParsingStats m_stats;
+#endif
+  };
+
+  // Parses the input into a tree with the keys interned in the pool.
+  // The pool may be shared with parsers running on other threads.
+  InternedParsingResult parse(KeyPool& keys);
+
+#if defined(PARSER_WITH_PMR)
+  using PmrParsedTree = std::pmr::map<std::pmr::string, std::pmr::string>;
+
+  struct PmrParsingResult {
+    explicit PmrParsingResult(std::pmr::memory_resource* resource)
+      : m_success(false)
+      , m_tree(resource)
+      , m_error()
+    {}
+
+    bool m_success;
+
+    PmrParsedTree m_tree;
+    ParsingError m_error;
+
+#if defined(PARSER_WITH_STATS)
+    ParsingStats m_stats;
+#endif
+  };
+
+  // Parses the input into a tree allocated from the memory resource.
+  // With a monotonic resource, the whole result is released at once
+  // when the resource is released.
+  PmrParsingResult parse(std::pmr::memory_resource* resource);
+#endif // PARSER_WITH_PMR
+
+  // Parses the file contents. Regular files are memory-mapped and lexed
+  // straight from the mapping, other files are read into memory first.
+  static ParsingResult parseFile(std::string const& path);
+
+  // Parses contiguous in-memory data on several threads. The root section
+  // entries are split into chunks, which are parsed on the internal
+  // thread pool and merged in the document order, so the result is
+  // the same as of parse(). Invalid input is parsed serially again
+  // to report the error. Zero thread count means all hardware threads.
+  static ParsingResult parseParallel(char const* data, size_t size,
+    size_t threadCount = 0);
+
+  // Parses independent in-memory documents on the internal thread pool.
+  // Each thread reuses its parser and scratch buffers between documents.
+  // Results are in the input order. Zero thread count means all hardware
+  // threads.
+  static std::vector<ParsingResult> parseBatch(TextView const* inputs,
+    size_t count, size_t threadCount = 0);
+
+  // Parses only the entries selected by the projection from contiguous
+  // in-memory data. Other entries are skipped by matching braces and
+  // quotes, with no tokens read or values decoded, so the errors within
+  // them are not found. Selected entries are parsed as by parse().
+  // Malformed input is parsed again as a whole to report the error.
+  static ParsingResult parseProjection(char const* data, size_t size,
+    Projection const& projection);
+
   static constexpr char s_categorySeparator = ':';
 
+  // Maximum supported nesting of sections, including the root one
+  static constexpr size_t s_maxSectionDepth = 512;
+
 private:
+  friend class PushParser;
+
   class impl;
 
   Lexer m_lexer;
 };
 
+// Incremental parser consuming the input by portions as they arrive.
+// Complete tokens are parsed immediately, and the parser state is kept
+// between the portions along with the bytes of an incomplete token.
+class PushParser {
+public:
+  PushParser();
+
+  // Reports the parsed data to the handler. The resulting tree
+  // is not built.
+  explicit PushParser(ParsingHandler& handler);
+
+  ~PushParser();
+
+  // Parses the portion of the input. Returns false if the input
+  // is already known to be invalid.
+  bool feed(char const* data, size_t size);
+
+  // Checks if the root section has been parsed completely
+  bool isComplete() const;
+
+  // Parses the rest of the input and returns the result. The parser
+  // is then ready for a new input.
+  Parser::ParsingResult finish();
+
+private:
+  class impl;
+
+  std::unique_ptr<impl> m_impl;
+};
+
 } // namespace parsing
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "parser.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+
+namespace parsing {
+
+// Set of key paths to extract from documents, compiled once to match
+// the keys while scanning.
+//
+// Paths are keys joined with Parser::s_categorySeparator, as in parsed
+// trees. A path of a section selects the section entry and all entries
+// within the section. An empty path selects the whole document.
+class Projection {
+public:
+  Projection();
+  Projection(std::initializer_list<TextView> paths);
+  explicit Projection(std::vector<std::string> const& paths);
+
+  void add(TextView path);
+
+  size_t getPathCount() const;
+
+  // Checks if the key of a parsed tree is selected by the paths
+  bool selects(TextView key) const;
+
+private:
+  friend class Parser;
+
+  // Nodes are numbered in the order of adding, the root one is 0.
+  // Children are sorted by key.
+  struct Child {
+    std::string m_key;
+    uint32_t m_node;
+  };
+
+  struct Node {
+    std::vector<Child> m_children;
+    bool m_isSelected;
+  };
+
+  // Returned for the keys out of the paths
+  static constexpr uint32_t s_noNode = 0;
+
+  static constexpr uint32_t s_root = 0;
+
+  // Returns the node of the child key, or s_noNode
+  uint32_t findChild(uint32_t node, TextView key) const;
+
+  bool isSelected(uint32_t node) const;
+
+  std::vector<Node> m_nodes;
+  size_t m_pathCount;
+};
+
+} // namespace parsing
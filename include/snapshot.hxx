@@ -0,0 +1,82 @@
+#pragma once
+
+#include "parser.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace parsing {
+
+class MappedFile;
+
+// Binary image of a parsed tree, usable without parsing.
+//
+// The image consists of a header, a table of entries sorted by key and
+// a pool of key and value texts. The table and the pool are protected
+// by a checksum. The header also keeps the hash of the source text,
+// which allows to check if the snapshot is up to date. Images use
+// the native byte order.
+//
+// Opened snapshots are read straight from the file mapping: lookups
+// are binary searches in the table, and the texts reference the pool.
+class Snapshot {
+public:
+  Snapshot();
+  ~Snapshot();
+
+  Snapshot(Snapshot&& other) noexcept;
+  Snapshot& operator = (Snapshot&& other) noexcept;
+
+  // Makes the image of the tree parsed from the source with the hash.
+  // Returns an empty image if the texts do not fit 4 GiB.
+  static std::string serialize(Parser::ParsedTree const& tree,
+    uint64_t sourceHash);
+
+  static bool writeFile(std::string const& path,
+    Parser::ParsedTree const& tree, uint64_t sourceHash);
+
+  // Non-cryptographic hash of the source text
+  static uint64_t hashSource(char const* data, size_t size);
+
+  // Maps the image file. The image structure and checksum are checked,
+  // so the whole file is read once.
+  bool open(std::string const& path);
+
+  // Uses the image in memory, which must outlive the snapshot and be
+  // aligned to 8 bytes
+  bool open(char const* data, size_t size);
+
+  void close();
+
+  bool isOpen() const;
+
+  // Entries are ordered by key
+  size_t getEntryCount() const;
+  TextView getKey(size_t index) const;
+  TextView getValue(size_t index) const;
+
+  // Finds the value by key. Returns false if there is no such key.
+  bool find(TextView key, TextView& value) const;
+
+  uint64_t getSourceHash() const;
+
+  // Checks if the snapshot is made from the source text
+  bool isMadeFrom(char const* data, size_t size) const;
+
+private:
+  struct Header;
+  struct Entry;
+
+  Entry const& getEntry(size_t index) const;
+  TextView getText(uint32_t offset, uint32_t size) const;
+
+  std::unique_ptr<MappedFile> m_file;
+  Header const* m_header;
+  Entry const* m_entries;
+  char const* m_pool;
+};
+
+} // namespace parsing
@@ -0,0 +1,599 @@
+#pragma once
+
+#include "parser.hxx"
+
+#include <cstddef>
+#include <stdexcept>
+
+
+namespace parsing {
+namespace static_parsing {
+
+//
+// Compile-time parsing of embedded documents.
+//
+// PARSING_STATIC_TREE("{ ... }") makes a constant table of the entries
+// of a string literal with the keys and values of Parser::ParsedTree.
+// Entries are sorted by key, so lookups are binary searches. Malformed
+// literals fail the compilation, or throw std::invalid_argument when
+// parsed at run time. The table is sorted with an insertion sort,
+// which is meant for small embedded documents.
+//
+
+// Constant view of a text
+class StaticText {
+public:
+  constexpr StaticText()
+    : m_data("")
+    , m_size(0)
+  {}
+
+  constexpr StaticText(char const* data, size_t size)
+    : m_data(data)
+    , m_size(size)
+  {}
+
+  template <size_t Size>
+  constexpr StaticText(char const (&literal)[Size])
+    : m_data(literal)
+    , m_size(Size - 1)
+  {}
+
+  constexpr char const* getData() const
+  {
+    return m_data;
+  }
+
+  constexpr size_t getSize() const
+  {
+    return m_size;
+  }
+
+  constexpr char operator [] (size_t index) const
+  {
+    return m_data[index];
+  }
+
+  // Compares the bytes as unsigned, like std::string does
+  constexpr int compare(StaticText other) const
+  {
+    for (size_t i = 0; (i != m_size) && (i != other.m_size); ++i) {
+      unsigned char const a = static_cast<unsigned char>(m_data[i]);
+      unsigned char const b = static_cast<unsigned char>(other.m_data[i]);
+      if (a != b) {
+        return (a < b) ? -1 : 1;
+      }
+    }
+    return (m_size < other.m_size) ? -1 : (other.m_size < m_size) ? 1 : 0;
+  }
+
+  TextView toTextView() const
+  {
+    return TextView(m_data, m_size);
+  }
+
+private:
+  char const* m_data;
+  size_t m_size;
+};
+
+constexpr bool operator == (StaticText a, StaticText b)
+{
+  return a.compare(b) == 0;
+}
+
+constexpr bool operator != (StaticText a, StaticText b)
+{
+  return !(a == b);
+}
+
+constexpr bool operator < (StaticText a, StaticText b)
+{
+  return a.compare(b) < 0;
+}
+
+
+// Capacities required for the tree of a document
+struct Size {
+  size_t m_entryCount;
+  size_t m_textSize; // of keys and undecoded values
+};
+
+namespace detail {
+template <class Tree>
+class TreeBuilder;
+} // namespace detail
+
+// Sorted table of the document entries
+template <size_t EntryCapacity, size_t TextCapacity>
+class StaticTree {
+public:
+  constexpr StaticTree()
+    : m_texts{}
+    , m_entries{}
+    , m_size(0)
+    , m_textSize(0)
+  {}
+
+  constexpr size_t getSize() const
+  {
+    return m_size;
+  }
+
+  constexpr StaticText getKey(size_t index) const
+  {
+    return getText(m_entries[index].m_key, m_entries[index].m_keySize);
+  }
+
+  constexpr StaticText getValue(size_t index) const
+  {
+    return getText(m_entries[index].m_value, m_entries[index].m_valueSize);
+  }
+
+  // Finds the value by key. Returns false if there is no such key.
+  constexpr bool find(StaticText key, StaticText& value) const
+  {
+    size_t first = 0;
+    size_t count = m_size;
+    while (count != 0) {
+      size_t const step = count / 2;
+      if (getKey(first + step) < key) {
+        first += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+
+    if ((first == m_size) || (getKey(first) != key)) {
+      return false;
+    }
+    value = getValue(first);
+    return true;
+  }
+
+private:
+  // Texts are referenced by offsets, so the tree can be copied
+  struct Entry {
+    size_t m_key;
+    size_t m_keySize;
+    size_t m_value;
+    size_t m_valueSize;
+  };
+
+  friend class detail::TreeBuilder<StaticTree>;
+
+  constexpr StaticText getText(size_t offset, size_t size) const
+  {
+    return StaticText(m_texts + offset, size);
+  }
+
+  // Arrays are never empty, so empty documents are supported
+  char m_texts[TextCapacity + 1];
+  Entry m_entries[EntryCapacity + 1];
+  size_t m_size;
+  size_t m_textSize;
+};
+
+
+namespace detail {
+
+constexpr bool isIgnored(char c)
+{
+  return ((0x00 <= c) && (c <= 0x20)) || (c == 0x7F);
+}
+
+constexpr bool isKeyChar(char c)
+{
+  return (('a' <= c) && (c <= 'z'))
+    || (('A' <= c) && (c <= 'Z'))
+    || (('0' <= c) && (c <= '9'))
+    || (c == '_');
+}
+
+constexpr int getHexDigit(char c)
+{
+  return (('0' <= c) && (c <= '9')) ? (c - '0')
+    : (('a' <= c) && (c <= 'f')) ? (c - 'a' + 10)
+    : (('A' <= c) && (c <= 'F')) ? (c - 'A' + 10)
+    : throw std::invalid_argument("Unexpected symbol in escape sequence");
+}
+
+// Reads the input with the same rules as the lexer
+class Reader {
+public:
+  constexpr explicit Reader(StaticText input)
+    : m_input(input)
+    , m_position(0)
+  {}
+
+  constexpr void skipBom()
+  {
+    if ((m_input.getSize() != 0) && (m_input[0] == '\xEF')) {
+      expect('\xEF', "Wrong BOM");
+      expect('\xBB', "Wrong BOM");
+      expect('\xBF', "Wrong BOM");
+    }
+  }
+
+  constexpr void skipIgnored()
+  {
+    while ((m_position != m_input.getSize()) &&
+        isIgnored(m_input[m_position]))
+    {
+      ++m_position;
+    }
+  }
+
+  constexpr bool check(char c)
+  {
+    skipIgnored();
+    return (m_position != m_input.getSize()) && (m_input[m_position] == c);
+  }
+
+  constexpr void expect(char c, char const* message)
+  {
+    if ((m_position == m_input.getSize()) || (m_input[m_position] != c)) {
+      throw std::invalid_argument(message);
+    }
+    ++m_position;
+  }
+
+  constexpr StaticText readKey()
+  {
+    skipIgnored();
+    size_t const begin = m_position;
+    while ((m_position != m_input.getSize()) &&
+        isKeyChar(m_input[m_position]))
+    {
+      ++m_position;
+    }
+    if (m_position == begin) {
+      throw std::invalid_argument("Expected key");
+    }
+    return StaticText(m_input.getData() + begin, m_position - begin);
+  }
+
+  // Returns the value text between the quotes, checking escape sequences
+  constexpr StaticText readValue()
+  {
+    skipIgnored();
+    expect('"', "Expected value");
+    size_t const begin = m_position;
+    while (true) {
+      if (m_position == m_input.getSize()) {
+        throw std::invalid_argument("Unexpected end of data");
+      }
+
+      char const c = m_input[m_position];
+      if (c == '"') {
+        break;
+      } else if (c == '\\') {
+        m_position = skipEscape(m_position + 1);
+      } else if (((0x00 <= c) && (c < 0x20)) || (c == 0x7F)) {
+        throw std::invalid_argument("Unexpected character");
+      } else {
+        ++m_position;
+      }
+    }
+    ++m_position;
+    return StaticText(m_input.getData() + begin, m_position - begin - 1);
+  }
+
+  // Decodes the value text, returns the decoded size
+  static constexpr size_t decodeValue(StaticText text, char* output)
+  {
+    size_t size = 0;
+    for (size_t i = 0; i != text.getSize(); ) {
+      if (text[i] != '\\') {
+        output[size++] = text[i++];
+        continue;
+      }
+
+      char const kind = text[i + 1];
+      if (kind != 'x') {
+        output[size++] = (kind == 'n') ? '\n' : (kind == 'r') ? '\r' : '\\';
+        i += 2;
+        continue;
+      }
+
+      long codepoint = readCodepoint(text, i + 2);
+      i += 6;
+      if ((0xD800 <= codepoint) && (codepoint <= 0xDBFF)) {
+        codepoint = (codepoint << 10) + readCodepoint(text, i + 2)
+          - 0x35FDC00;
+        i += 6;
+      }
+      size += encodeCodepoint(codepoint, output + size);
+    }
+    return size;
+  }
+
+private:
+  // Checks the escape sequence, returns its end
+  constexpr size_t skipEscape(size_t position) const
+  {
+    if (position == m_input.getSize()) {
+      throw std::invalid_argument("Unexpected end of data");
+    }
+
+    char const kind = m_input[position];
+    if ((kind == 'n') || (kind == 'r') || (kind == '\\')) {
+      return position + 1;
+    } else if (kind != 'x') {
+      throw std::invalid_argument("Unknown escape sequence");
+    }
+
+    long const codepoint = readCodepoint(m_input, position + 1);
+    position += 5;
+    if ((0xD800 <= codepoint) && (codepoint <= 0xDBFF)) {
+      if ((m_input.getSize() - position < 2) ||
+          (m_input[position] != '\\') || (m_input[position + 1] != 'x'))
+      {
+        throw std::invalid_argument("Expected low surrogate in pair");
+      }
+      long const lowSurrogate = readCodepoint(m_input, position + 2);
+      if ((lowSurrogate < 0xDC00) || (0xDFFF < lowSurrogate)) {
+        throw std::invalid_argument("Wrong low surrogate in pair");
+      }
+      position += 6;
+    }
+    return position;
+  }
+
+  static constexpr long readCodepoint(StaticText text, size_t position)
+  {
+    if (text.getSize() - position < 4) {
+      throw std::invalid_argument("Unexpected end of data");
+    }
+
+    long codepoint = 0;
+    for (size_t i = 0; i != 4; ++i) {
+      codepoint = (codepoint << 4) | getHexDigit(text[position + i]);
+    }
+    return codepoint;
+  }
+
+  static constexpr size_t encodeCodepoint(long codepoint, char* output)
+  {
+    if (codepoint < 0x80) {
+      output[0] = char(codepoint);
+      return 1;
+    } else if (codepoint < 0x800) {
+      output[0] = char(0xC0 | (codepoint >> 6));
+      output[1] = char(0x80 | (codepoint & 0x3F));
+      return 2;
+    } else if (codepoint < 0x10000) {
+      output[0] = char(0xE0 | (codepoint >> 12));
+      output[1] = char(0x80 | ((codepoint >> 6) & 0x3F));
+      output[2] = char(0x80 | (codepoint & 0x3F));
+      return 3;
+    }
+    output[0] = char(0xF0 | (codepoint >> 18));
+    output[1] = char(0x80 | ((codepoint >> 12) & 0x3F));
+    output[2] = char(0x80 | ((codepoint >> 6) & 0x3F));
+    output[3] = char(0x80 | (codepoint & 0x3F));
+    return 4;
+  }
+
+  StaticText m_input;
+  size_t m_position;
+};
+
+// Parses the document, reporting the sections and entries to the sink
+// like to a ParsingHandler. Value texts are reported undecoded.
+template <class Sink>
+constexpr void parseDocument(StaticText input, Sink& sink)
+{
+  Reader reader(input);
+  reader.skipBom();
+  reader.skipIgnored();
+  reader.expect('{', "Expected section begin");
+  sink.onSectionBegin(StaticText());
+
+  // Sections start with an entry or end, entries are followed
+  // by a separator and an entry, or by the section end
+  size_t depth = 1;
+  bool isAfterEntry = false;
+  while (depth != 0) {
+    if (reader.check('}')) {
+      reader.expect('}', "Expected section end");
+      sink.onSectionEnd();
+      --depth;
+      isAfterEntry = true;
+      continue;
+    }
+
+    if (isAfterEntry) {
+      reader.expect(',', "Expected entry separator");
+    }
+
+    StaticText const key = reader.readKey();
+    if (!reader.check(':')) {
+      throw std::invalid_argument("Expected key-value separator");
+    }
+    reader.expect(':', "Expected key-value separator");
+
+    if (reader.check('{')) {
+      if (depth == Parser::s_maxSectionDepth) {
+        throw std::invalid_argument("Nesting is too deep");
+      }
+      reader.expect('{', "Expected section begin");
+      sink.onSectionBegin(key);
+      ++depth;
+      isAfterEntry = false;
+    } else {
+      sink.onEntry(key, reader.readValue());
+      isAfterEntry = true;
+    }
+  }
+}
+
+// Counts the tree capacities
+class Measurer {
+public:
+  constexpr Measurer()
+    : m_size{ 0, 0 }
+    , m_pathSizes{}
+    , m_depth(0)
+  {}
+
+  constexpr void onSectionBegin(StaticText key)
+  {
+    size_t pathSize = 0;
+    if (m_depth != 0) {
+      pathSize = addKey(key);
+      ++m_size.m_entryCount;
+    }
+    m_pathSizes[m_depth++] = pathSize;
+  }
+
+  constexpr void onSectionEnd()
+  {
+    --m_depth;
+  }
+
+  constexpr void onEntry(StaticText key, StaticText value)
+  {
+    addKey(key);
+    m_size.m_textSize += value.getSize();
+    ++m_size.m_entryCount;
+  }
+
+  constexpr Size getSize() const
+  {
+    return m_size;
+  }
+
+private:
+  constexpr size_t addKey(StaticText key)
+  {
+    size_t const parentSize = m_pathSizes[m_depth - 1];
+    size_t const size =
+      parentSize + ((parentSize != 0) ? 1 : 0) + key.getSize();
+    m_size.m_textSize += size;
+    return size;
+  }
+
+  Size m_size;
+  size_t m_pathSizes[Parser::s_maxSectionDepth];
+  size_t m_depth;
+};
+
+// Writes keys and decoded values to the tree texts. Full keys of
+// sections are used as the paths of their entries.
+template <class Tree>
+class TreeBuilder {
+public:
+  constexpr TreeBuilder()
+    : m_tree()
+    , m_paths{}
+    , m_depth(0)
+  {}
+
+  constexpr void onSectionBegin(StaticText key)
+  {
+    Entry path = {};
+    if (m_depth != 0) {
+      path = addEntry(key);
+    }
+    m_paths[m_depth++] = path;
+  }
+
+  constexpr void onSectionEnd()
+  {
+    --m_depth;
+  }
+
+  constexpr void onEntry(StaticText key, StaticText value)
+  {
+    Entry entry = addEntry(key);
+    entry.m_valueSize =
+      Reader::decodeValue(value, m_tree.m_texts + m_tree.m_textSize);
+    m_tree.m_textSize += entry.m_valueSize;
+    m_tree.m_entries[m_tree.m_size - 1] = entry;
+  }
+
+  // Sorts the entries by key and keeps the first of equal keys,
+  // as in Parser::ParsedTree
+  constexpr Tree takeTree()
+  {
+    for (size_t i = 1; i < m_tree.m_size; ++i) {
+      Entry const entry = m_tree.m_entries[i];
+      StaticText const key = m_tree.getText(entry.m_key, entry.m_keySize);
+      size_t j = i;
+      for (; (j != 0) && (key < m_tree.getKey(j - 1)); --j) {
+        m_tree.m_entries[j] = m_tree.m_entries[j - 1];
+      }
+      m_tree.m_entries[j] = entry;
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i != m_tree.m_size; ++i) {
+      if ((size == 0) || (m_tree.getKey(i) != m_tree.getKey(size - 1))) {
+        m_tree.m_entries[size++] = m_tree.m_entries[i];
+      }
+    }
+    m_tree.m_size = size;
+
+    return m_tree;
+  }
+
+private:
+  using Entry = typename Tree::Entry;
+
+  constexpr Entry addEntry(StaticText key)
+  {
+    Entry const parent = m_paths[m_depth - 1];
+
+    Entry entry = {};
+    entry.m_key = m_tree.m_textSize;
+    for (size_t i = 0; i != parent.m_keySize; ++i) {
+      m_tree.m_texts[m_tree.m_textSize++] = m_tree.m_texts[parent.m_key + i];
+    }
+    if (parent.m_keySize != 0) {
+      m_tree.m_texts[m_tree.m_textSize++] = Parser::s_categorySeparator;
+    }
+    for (size_t i = 0; i != key.getSize(); ++i) {
+      m_tree.m_texts[m_tree.m_textSize++] = key[i];
+    }
+    entry.m_keySize = m_tree.m_textSize - entry.m_key;
+    entry.m_value = m_tree.m_textSize;
+    entry.m_valueSize = 0;
+
+    m_tree.m_entries[m_tree.m_size++] = entry;
+    return entry;
+  }
+
+  Tree m_tree;
+  Entry m_paths[Parser::s_maxSectionDepth];
+  size_t m_depth;
+};
+
+} // namespace detail
+
+// Returns the capacities required for the tree of the document
+constexpr Size measure(StaticText input)
+{
+  detail::Measurer measurer;
+  detail::parseDocument(input, measurer);
+  return measurer.getSize();
+}
+
+template <size_t EntryCapacity, size_t TextCapacity>
+constexpr StaticTree<EntryCapacity, TextCapacity> makeTree(
+  StaticText input)
+{
+  detail::TreeBuilder<StaticTree<EntryCapacity, TextCapacity>> builder;
+  detail::parseDocument(input, builder);
+  return builder.takeTree();
+}
+
+} // namespace static_parsing
+} // namespace parsing
+
+// Makes the constant tree of the document in the string literal
+#define PARSING_STATIC_TREE(literal) \
+  ::parsing::static_parsing::makeTree< \
+    ::parsing::static_parsing::measure(literal).m_entryCount, \
+    ::parsing::static_parsing::measure(literal).m_textSize>(literal)
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "parser.hxx"
+
+#include <string>
+
+
+namespace parsing {
+
+enum class WritingStyle {
+  Compact, // no whitespace, for transport
+  Pretty // an entry per line, indented by nesting
+};
+
+// Writes parsed trees back as documents.
+//
+// Sections are rebuilt from the keys joined with
+// Parser::s_categorySeparator. A key with child keys is written as
+// a section, so its own value is dropped. Empty sections are kept in
+// the tree as empty values and are written as such, which parses back
+// to the same tree. Keys are written as they are, so they must be valid
+// grammar keys. Values are escaped: quotes and control characters
+// become code point escapes.
+class Writer {
+public:
+  explicit Writer(WritingStyle style = WritingStyle::Pretty);
+
+  // Appends the document to the output
+  void write(Parser::ParsedTree const& tree, std::string& output) const;
+
+  // Writes the document to the file descriptor by large blocks.
+  // Returns false on a write error.
+  bool write(Parser::ParsedTree const& tree, int fd) const;
+
+private:
+  class impl;
+
+  WritingStyle m_style;
+};
+
+} // namespace parsing
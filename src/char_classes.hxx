@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace parsing {
+namespace char_classes {
+
+//
+// Locale-free byte classification for the lexer.
+//
+// Classes are looked up in a 256-entry table generated at compile time,
+// so classifying a byte is a single load from read-only memory with no
+// locale facet lookups and no shared mutable state.
+//
+
+// Class of the first byte of a token
+enum class Lead : uint8_t {
+  Other = 0,
+  Ignored,
+  Key,
+  Value,
+  SectionBegin,
+  SectionEnd,
+  KeyValueSeparator,
+  EntrySeparator
+};
+
+// Properties of a byte inside of tokens
+enum Flags : uint8_t {
+  None = 0,
+  Ignored = 1 << 0, // whitespace and control characters
+  KeyChar = 1 << 1, // [a-zA-Z0-9_]
+  KeyEnd = 1 << 2, // key separator and ignored characters
+  ValueSpecial = 1 << 3, // value end, escape and control characters
+  Structural = 1 << 4 // value and section bounds, entry separator
+};
+
+struct Table {
+  Lead m_lead[256];
+  uint8_t m_flags[256];
+};
+
+constexpr uint8_t classify(unsigned char c)
+{
+  bool const isControl = (c < 0x20) || (c == 0x7F);
+  bool const isIgnored = isControl || (c == ' ');
+  bool const isKeyChar = (('a' <= c) && (c <= 'z'))
+    || (('A' <= c) && (c <= 'Z'))
+    || (('0' <= c) && (c <= '9'))
+    || (c == '_');
+
+  uint8_t flags = None;
+  if (isIgnored) {
+    flags |= Ignored | KeyEnd;
+  }
+  if (isKeyChar) {
+    flags |= KeyChar;
+  }
+  if (c == ':') {
+    flags |= KeyEnd;
+  }
+  if (isControl || (c == '"') || (c == '\\')) {
+    flags |= ValueSpecial;
+  }
+  if ((c == '"') || (c == '{') || (c == '}') || (c == ',')) {
+    flags |= Structural;
+  }
+  return flags;
+}
+
+constexpr Lead classifyLead(unsigned char c)
+{
+  return (classify(c) & Ignored) ? Lead::Ignored
+    : (classify(c) & KeyChar) ? Lead::Key
+    : (c == '"') ? Lead::Value
+    : (c == '{') ? Lead::SectionBegin
+    : (c == '}') ? Lead::SectionEnd
+    : (c == ':') ? Lead::KeyValueSeparator
+    : (c == ',') ? Lead::EntrySeparator
+    : Lead::Other;
+}
+
+constexpr Table makeTable()
+{
+  Table table = {};
+  for (int c = 0; c != 256; ++c) {
+    table.m_lead[c] = classifyLead(static_cast<unsigned char>(c));
+    table.m_flags[c] = classify(static_cast<unsigned char>(c));
+  }
+  return table;
+}
+
+constexpr Table s_table = makeTable();
+
+constexpr Lead getLead(char c)
+{
+  return s_table.m_lead[static_cast<unsigned char>(c)];
+}
+
+constexpr bool is(char c, Flags flags)
+{
+  return (s_table.m_flags[static_cast<unsigned char>(c)] & flags) != 0;
+}
+
+} // namespace char_classes
+} // namespace parsing
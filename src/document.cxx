@@ -0,0 +1,305 @@
+#include "document.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+
+namespace parsing {
+
+constexpr size_t Arena::s_defaultBlockSize;
+
+Arena::Arena(size_t blockSize)
+  : m_blocks()
+  , m_reservedSize(0)
+  , m_blockSize(blockSize)
+  , m_current(nullptr)
+  , m_end(nullptr)
+{}
+
+Arena::Arena(Arena&& other) noexcept
+  : m_blocks(std::move(other.m_blocks))
+  , m_reservedSize(other.m_reservedSize)
+  , m_blockSize(other.m_blockSize)
+  , m_current(other.m_current)
+  , m_end(other.m_end)
+{
+  other.clear();
+}
+
+Arena& Arena::operator = (Arena&& other) noexcept
+{
+  if (this != &other) {
+    m_blocks = std::move(other.m_blocks);
+    m_reservedSize = other.m_reservedSize;
+    m_blockSize = other.m_blockSize;
+    m_current = other.m_current;
+    m_end = other.m_end;
+    other.clear();
+  }
+  return *this;
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+  auto getPadding = [&] (char const* position) {
+    uintptr_t const address = reinterpret_cast<uintptr_t>(position);
+    return (alignment - address % alignment) % alignment;
+  };
+
+  if (m_current &&
+      (getPadding(m_current) + size <= size_t(m_end - m_current)))
+  {
+    char* const result = m_current + getPadding(m_current);
+    m_current = result + size;
+    return result;
+  }
+
+  // Oversized requests get a dedicated block
+  size_t const blockSize = std::max(m_blockSize, size + alignment);
+  m_blocks.emplace_back(new char[blockSize]);
+  m_reservedSize += blockSize;
+
+  char* const block = m_blocks.back().get();
+  char* const result = block + getPadding(block);
+  m_current = result + size;
+  m_end = block + blockSize;
+  return result;
+}
+
+TextView Arena::copyText(TextView text)
+{
+  if (text.isEmpty()) {
+    return TextView();
+  }
+
+  char* const data = allocateArray<char>(text.getSize());
+  std::memcpy(data, text.getData(), text.getSize());
+  return TextView(data, text.getSize());
+}
+
+void Arena::clear()
+{
+  m_blocks.clear();
+  m_reservedSize = 0;
+  m_current = nullptr;
+  m_end = nullptr;
+}
+
+size_t Arena::getReservedSize() const
+{
+  return m_reservedSize;
+}
+
+
+TextView DocumentNode::getKey() const
+{
+  return m_key;
+}
+
+TextView DocumentNode::getValue() const
+{
+  return m_value;
+}
+
+bool DocumentNode::isSection() const
+{
+  return m_isSection;
+}
+
+size_t DocumentNode::getChildCount() const
+{
+  return m_childCount;
+}
+
+DocumentNode const& DocumentNode::getChild(size_t index) const
+{
+  return *m_children[index];
+}
+
+DocumentNode::const_iterator DocumentNode::begin() const
+{
+  return m_children;
+}
+
+DocumentNode::const_iterator DocumentNode::end() const
+{
+  return m_children + m_childCount;
+}
+
+DocumentNode const* DocumentNode::find(TextView key) const
+{
+  auto const iChild = std::lower_bound(begin(), end(), key,
+    [] (DocumentNode const* node, TextView const& key) {
+      return node->m_key < key;
+    });
+  if ((iChild == end()) || ((*iChild)->m_key != key)) {
+    return nullptr;
+  }
+  return *iChild;
+}
+
+DocumentNode const* DocumentNode::findPath(TextView path) const
+{
+  DocumentNode const* node = this;
+
+  auto iPart = path.begin();
+  auto const iPathEnd = path.end();
+  while (node) {
+    auto const iPartEnd =
+      std::find(iPart, iPathEnd, Parser::s_categorySeparator);
+    node = node->find(TextView(iPart, iPartEnd - iPart));
+    if (iPartEnd == iPathEnd) {
+      break;
+    }
+    iPart = iPartEnd + 1;
+  }
+
+  return node;
+}
+
+
+// Handler building document nodes in the arena
+class Document::Builder : public ParsingHandler {
+public:
+  explicit Builder(Arena& arena)
+    : m_arena(arena)
+    , m_root(nullptr)
+  {}
+
+  void onSectionBegin(TextView key) override
+  {
+    DocumentNode* const node = createNode(key, TextView(), true);
+    if (m_sections.empty()) {
+      m_root = node;
+    } else {
+      m_children.push_back(node);
+    }
+    m_sections.push_back({ node, m_children.size() });
+  }
+
+  void onSectionEnd() override
+  {
+    // Children are collected in the scratch list while the section is
+    // open, and moved to the arena when its size is known
+    OpenSection const section = m_sections.back();
+    m_sections.pop_back();
+
+    auto const iChildren = m_children.begin() + section.m_firstChild;
+    size_t const count = m_children.end() - iChildren;
+    DocumentNode const** const children =
+      m_arena.allocateArray<DocumentNode const*>(count);
+    std::copy(iChildren, m_children.end(), children);
+    std::stable_sort(children, children + count,
+      [] (DocumentNode const* a, DocumentNode const* b) {
+        return a->m_key < b->m_key;
+      });
+    m_children.erase(iChildren, m_children.end());
+
+    section.m_node->m_children = children;
+    section.m_node->m_childCount = count;
+  }
+
+  void onEntry(TextView key, TextView value) override
+  {
+    m_children.push_back(createNode(key, value, false));
+  }
+
+  DocumentNode const* getRoot() const
+  {
+    return m_root;
+  }
+
+private:
+  DocumentNode* createNode(TextView key, TextView value, bool isSection)
+  {
+    DocumentNode* const node = new (m_arena.allocate(sizeof(DocumentNode),
+      alignof(DocumentNode))) DocumentNode();
+    node->m_key = m_arena.copyText(key);
+    node->m_value = m_arena.copyText(value);
+    node->m_isSection = isSection;
+    node->m_children = nullptr;
+    node->m_childCount = 0;
+    return node;
+  }
+
+  struct OpenSection {
+    DocumentNode* m_node;
+    size_t m_firstChild;
+  };
+
+  Arena& m_arena;
+  DocumentNode* m_root;
+  std::vector<OpenSection> m_sections;
+  std::vector<DocumentNode const*> m_children;
+};
+
+namespace {
+
+DocumentNode const& getEmptyRoot()
+{
+  static DocumentNode const root = DocumentNode();
+  return root;
+}
+
+} // namespace
+
+Document::Document()
+  : m_arena()
+  , m_root(&getEmptyRoot())
+{}
+
+Document::Document(Document&& other) noexcept
+  : m_arena(std::move(other.m_arena))
+  , m_root(other.m_root)
+{
+  other.m_root = &getEmptyRoot();
+}
+
+Document& Document::operator = (Document&& other) noexcept
+{
+  if (this != &other) {
+    m_arena = std::move(other.m_arena);
+    m_root = other.m_root;
+    other.m_root = &getEmptyRoot();
+  }
+  return *this;
+}
+
+Parser::ParsingResult Document::parse(Parser& parser)
+{
+  clear();
+
+  Builder builder(m_arena);
+  Parser::ParsingResult result = parser.parse(builder);
+  if (result.m_success && builder.getRoot()) {
+    m_root = builder.getRoot();
+  } else {
+    clear();
+  }
+  return result;
+}
+
+DocumentNode const& Document::getRoot() const
+{
+  return *m_root;
+}
+
+DocumentNode const* Document::findPath(TextView path) const
+{
+  return m_root->findPath(path);
+}
+
+Arena const& Document::getArena() const
+{
+  return m_arena;
+}
+
+void Document::clear()
+{
+  m_arena.clear();
+  m_root = &getEmptyRoot();
+}
+
+} // namespace parsing
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+namespace parsing {
+namespace hashing {
+
+// Word-at-a-time multiplicative hash. It is fast and good at catching
+// accidental changes, but it is not a cryptographic one.
+inline uint64_t hashBytes(char const* data, size_t size, uint64_t hash)
+{
+  constexpr uint64_t multiplier = 0x9E3779B97F4A7C15;
+
+  auto mix = [&] (uint64_t word) {
+    hash = (hash ^ word) * multiplier;
+    hash ^= hash >> 29;
+  };
+
+  char const* const end = data + size;
+  for (; sizeof(uint64_t) <= size_t(end - data); data += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    mix(word);
+  }
+
+  // Data of empty texts may be null
+  uint64_t tail = 0;
+  if (size != 0) {
+    std::memcpy(&tail, data, size_t(end - data));
+  }
+  mix(tail);
+  mix(size);
+
+  return hash;
+}
+
+} // namespace hashing
+} // namespace parsing
@@ -0,0 +1,306 @@
+#include "key_pool.hxx"
+#include "document.hxx"
+#include "hashing.hxx"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+namespace parsing {
+
+namespace {
+
+uint64_t hashKey(TextView key)
+{
+  return hashing::hashBytes(key.getData(), key.getSize(), 0);
+}
+
+struct KeyHash {
+  size_t operator () (TextView key) const
+  {
+    return size_t(hashKey(key));
+  }
+};
+
+// Allocations made by CountingAllocator on this thread, which are
+// not freed yet
+TreeMemory& getLiveAllocations()
+{
+  static thread_local TreeMemory allocations;
+  return allocations;
+}
+
+// Allocator counting the live allocations. It has no state, so
+// the containers using it have the layout of the standard ones.
+template <class T>
+class CountingAllocator {
+public:
+  using value_type = T;
+
+  CountingAllocator() = default;
+
+  template <class U>
+  CountingAllocator(CountingAllocator<U> const&)
+  {}
+
+  T* allocate(size_t count)
+  {
+    T* const data = std::allocator<T>().allocate(count);
+    TreeMemory& allocations = getLiveAllocations();
+    ++allocations.m_allocationCount;
+    allocations.m_allocatedBytes += count * sizeof(T);
+    return data;
+  }
+
+  void deallocate(T* data, size_t count)
+  {
+    std::allocator<T>().deallocate(data, count);
+    TreeMemory& allocations = getLiveAllocations();
+    --allocations.m_allocationCount;
+    allocations.m_allocatedBytes -= count * sizeof(T);
+  }
+
+  template <class U>
+  bool operator == (CountingAllocator<U> const&) const
+  {
+    return true;
+  }
+
+  template <class U>
+  bool operator != (CountingAllocator<U> const&) const
+  {
+    return false;
+  }
+};
+
+using CountedString =
+  std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+
+// Copies the string with the same capacity
+CountedString copyCounted(std::string const& text)
+{
+  CountedString copy;
+  copy.reserve(text.capacity());
+  copy.assign(text.data(), text.size());
+  return copy;
+}
+
+KeyHandle copyCounted(KeyHandle key)
+{
+  return key;
+}
+
+template <class Key>
+TreeMemory measureCopy(std::map<Key, std::string> const& tree)
+{
+  using CountedKey = decltype(copyCounted(std::declval<Key const&>()));
+  using CountedTree = std::map<CountedKey, CountedString,
+    std::less<CountedKey>,
+    CountingAllocator<std::pair<CountedKey const, CountedString>>>;
+
+  TreeMemory const& allocations = getLiveAllocations();
+  TreeMemory const before = allocations;
+
+  CountedTree copy;
+  for (auto const& entry : tree) {
+    copy.emplace_hint(copy.end(), copyCounted(entry.first),
+      copyCounted(entry.second));
+  }
+
+  TreeMemory memory;
+  memory.m_allocationCount =
+    allocations.m_allocationCount - before.m_allocationCount;
+  memory.m_allocatedBytes =
+    allocations.m_allocatedBytes - before.m_allocatedBytes;
+  return memory;
+}
+
+} // namespace
+
+
+// Keys of a shard are numbered in the order of interning. The texts
+// are copied to the arena, and the views of them are kept in chunks
+// doubling in size. Chunks are never moved, so the views are read
+// with no lock.
+class KeyPool::Shard {
+public:
+  Shard()
+    : m_mutex()
+    , m_texts(s_textBlockSize)
+    , m_indices()
+    , m_keyCount(0)
+    , m_keyBytes(0)
+  {
+    for (auto& chunk : m_chunks) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~Shard()
+  {
+    for (auto& chunk : m_chunks) {
+      delete[] chunk.load(std::memory_order_relaxed);
+    }
+  }
+
+  uint32_t intern(TextView key)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto const iIndex = m_indices.find(key);
+    if (iIndex != m_indices.end()) {
+      return iIndex->second;
+    }
+
+    if (m_keyCount == s_maxShardKeys) {
+      throw std::length_error("Too many keys in a key pool shard");
+    }
+
+    uint32_t const index = m_keyCount;
+    uint32_t offset = 0;
+    size_t const chunk = getChunk(index, offset);
+    TextView* views = m_chunks[chunk].load(std::memory_order_relaxed);
+    if (!views) {
+      views = new TextView[s_firstChunkSize << chunk];
+      m_chunks[chunk].store(views, std::memory_order_release);
+    }
+
+    TextView const text = m_texts.copyText(key);
+    views[offset] = text;
+    m_indices.emplace(text, index);
+    ++m_keyCount;
+    m_keyBytes += key.getSize();
+    return index;
+  }
+
+  bool find(TextView key, uint32_t& index) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto const iIndex = m_indices.find(key);
+    if (iIndex == m_indices.end()) {
+      return false;
+    }
+    index = iIndex->second;
+    return true;
+  }
+
+  TextView getKey(uint32_t index) const
+  {
+    uint32_t offset = 0;
+    size_t const chunk = getChunk(index, offset);
+    return m_chunks[chunk].load(std::memory_order_acquire)[offset];
+  }
+
+  void addStats(Stats& stats) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    stats.m_keyCount += m_keyCount;
+    stats.m_keyBytes += m_keyBytes;
+    stats.m_reservedBytes += m_texts.getReservedSize();
+
+    // Hash table buckets and nodes of the common implementations
+    stats.m_reservedBytes += m_indices.bucket_count() * sizeof(void*) +
+      m_indices.size() * (sizeof(decltype(m_indices)::value_type) +
+        2 * sizeof(void*));
+
+    uint32_t offset = 0;
+    size_t const chunkCount =
+      (m_keyCount == 0) ? 0 : getChunk(m_keyCount - 1, offset) + 1;
+    for (size_t chunk = 0; chunk != chunkCount; ++chunk) {
+      stats.m_reservedBytes +=
+        (s_firstChunkSize << chunk) * sizeof(TextView);
+    }
+  }
+
+private:
+  // Vocabularies are mostly small, so are the blocks of texts
+  static constexpr size_t s_textBlockSize = 4 * 1024;
+
+  static constexpr uint32_t s_firstChunkSize = 64;
+  static constexpr size_t s_chunkCount = 32;
+
+  // Returns the chunk of the key index and the index in the chunk
+  static size_t getChunk(uint32_t index, uint32_t& offset)
+  {
+    // Chunk n starts at s_firstChunkSize * (2^n - 1)
+    uint64_t const position = uint64_t(index) / s_firstChunkSize + 1;
+    size_t chunk = 0;
+    while ((position >> (chunk + 1)) != 0) {
+      ++chunk;
+    }
+    offset =
+      uint32_t(index - s_firstChunkSize * ((uint64_t(1) << chunk) - 1));
+    return chunk;
+  }
+
+  mutable std::mutex m_mutex;
+
+  Arena m_texts;
+  std::unordered_map<TextView, uint32_t, KeyHash> m_indices;
+  std::atomic<TextView*> m_chunks[s_chunkCount];
+  uint32_t m_keyCount;
+  size_t m_keyBytes;
+};
+
+
+KeyPool::KeyPool()
+  : m_shards(new Shard[s_shardCount])
+{}
+
+KeyPool::~KeyPool() = default;
+
+KeyHandle KeyPool::intern(TextView key)
+{
+  // High hash bits select the shard, low ones are used by its table.
+  // Handles keep the shard in the low bits.
+  uint32_t const shard = uint32_t(hashKey(key) >> (64 - s_shardBits));
+  uint32_t const index = m_shards[shard].intern(key);
+  return KeyHandle((index << s_shardBits) | shard);
+}
+
+bool KeyPool::find(TextView key, KeyHandle& handle) const
+{
+  uint32_t const shard = uint32_t(hashKey(key) >> (64 - s_shardBits));
+  uint32_t index = 0;
+  if (!m_shards[shard].find(key, index)) {
+    return false;
+  }
+  handle = KeyHandle((index << s_shardBits) | shard);
+  return true;
+}
+
+TextView KeyPool::getKey(KeyHandle handle) const
+{
+  uint32_t const value = static_cast<uint32_t>(handle);
+  return m_shards[value & (s_shardCount - 1)].getKey(value >> s_shardBits);
+}
+
+KeyPool::Stats KeyPool::getStats() const
+{
+  Stats stats;
+  for (uint32_t shard = 0; shard != s_shardCount; ++shard) {
+    m_shards[shard].addStats(stats);
+  }
+  return stats;
+}
+
+TreeMemory measureTreeMemory(Parser::ParsedTree const& tree)
+{
+  return measureCopy(tree);
+}
+
+TreeMemory measureTreeMemory(Parser::InternedTree const& tree)
+{
+  return measureCopy(tree);
+}
+
+} // namespace parsing
@@ -0,0 +1,414 @@
+#include "lazy_document.hxx"
+#include "char_classes.hxx"
+#include "scanning.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+
+namespace parsing {
+
+namespace {
+
+// Handler of the validating parsing, which finds the error position
+class IgnoringHandler : public ParsingHandler {
+public:
+  void onSectionBegin(TextView) override {}
+  void onSectionEnd() override {}
+  void onEntry(TextView, TextView) override {}
+};
+
+int getHexDigit(char c)
+{
+  return (('0' <= c) && (c <= '9')) ? (c - '0')
+    : (('a' <= c) && (c <= 'f')) ? (c - 'a' + 10)
+    : (('A' <= c) && (c <= 'F')) ? (c - 'A' + 10)
+    : -1;
+}
+
+// Reads the 4 hex digits of a codepoint escape. Returns -1 if invalid.
+int readCodepoint(char const*& current, char const* end)
+{
+  if (end - current < 4) {
+    return -1;
+  }
+
+  int codepoint = 0;
+  for (int i = 0; i != 4; ++i) {
+    int const digit = getHexDigit(*current++);
+    if (digit < 0) {
+      return -1;
+    }
+    codepoint = (codepoint << 4) | digit;
+  }
+  return codepoint;
+}
+
+// Checks the escape sequence after the escape character the same way
+// as the lexer decodes it. Returns the sequence end, or null if the
+// sequence is invalid.
+char const* skipEscape(char const* current, char const* end)
+{
+  if (current == end) {
+    return nullptr;
+  }
+
+  switch (*current++) {
+    case 'n':
+    case 'r':
+    case '\\':
+      return current;
+    case 'x':
+      break;
+    default:
+      return nullptr;
+  }
+
+  int const codepoint = readCodepoint(current, end);
+  if (codepoint < 0) {
+    return nullptr;
+  }
+  if ((0xD800 <= codepoint) && (codepoint <= 0xDBFF)) {
+    if ((end - current < 2) || (current[0] != '\\') || (current[1] != 'x'))
+    {
+      return nullptr;
+    }
+    current += 2;
+    int const lowSurrogate = readCodepoint(current, end);
+    if ((lowSurrogate < 0xDC00) || (0xDFFF < lowSurrogate)) {
+      return nullptr;
+    }
+  }
+  return current;
+}
+
+} // namespace
+
+
+LazyNode::LazyNode()
+  : m_document(nullptr)
+  , m_index(0)
+{}
+
+LazyNode::LazyNode(LazyDocument const* document, uint32_t index)
+  : m_document(document)
+  , m_index(index)
+{}
+
+LazyNode::operator bool() const
+{
+  return m_document != nullptr;
+}
+
+TextView LazyNode::getKey() const
+{
+  LazyDocument::Node const& node = m_document->m_nodes[m_index];
+  return TextView(m_document->m_data + node.m_key, node.m_keySize);
+}
+
+TextView LazyNode::getValue() const
+{
+  LazyDocument::Node const& node = m_document->m_nodes[m_index];
+  if (node.m_flags & LazyDocument::Section) {
+    return TextView();
+  }
+
+  TextView const text(m_document->m_data + node.m_value, node.m_valueSize);
+  if (!(node.m_flags & LazyDocument::Escaped)) {
+    return text;
+  }
+
+  auto const iValue = m_document->m_values.find(m_index);
+  if (iValue != m_document->m_values.end()) {
+    return iValue->second;
+  }
+
+  // The value is checked by the indexing, so the lexer decodes it
+  // with no errors
+  Lexer lexer(text.getData() - 1, text.getSize() + 2);
+  TextView const value =
+    m_document->m_arena.copyText(lexer.getCurrent().getText());
+  m_document->m_values.emplace(m_index, value);
+  return value;
+}
+
+bool LazyNode::isSection() const
+{
+  return m_document->m_nodes[m_index].m_flags & LazyDocument::Section;
+}
+
+size_t LazyNode::getChildCount() const
+{
+  if (!isSection()) {
+    return 0;
+  }
+  return m_document->m_nodes[m_index].m_valueSize;
+}
+
+LazyNode LazyNode::getFirstChild() const
+{
+  if (getChildCount() == 0) {
+    return LazyNode();
+  }
+  return LazyNode(m_document, m_index + 1);
+}
+
+LazyNode LazyNode::getNextSibling() const
+{
+  uint32_t const next = m_document->m_nodes[m_index].m_next;
+  if (next == 0) {
+    return LazyNode();
+  }
+  return LazyNode(m_document, next);
+}
+
+LazyNode LazyNode::find(TextView key) const
+{
+  for (LazyNode child = getFirstChild(); child;
+      child = child.getNextSibling())
+  {
+    if (child.getKey() == key) {
+      return child;
+    }
+  }
+  return LazyNode();
+}
+
+LazyNode LazyNode::findPath(TextView path) const
+{
+  LazyNode node = *this;
+
+  auto iPart = path.begin();
+  auto const iPathEnd = path.end();
+  while (node) {
+    auto const iPartEnd =
+      std::find(iPart, iPathEnd, Parser::s_categorySeparator);
+    node = node.find(TextView(iPart, iPartEnd - iPart));
+    if (iPartEnd == iPathEnd) {
+      break;
+    }
+    iPart = iPartEnd + 1;
+  }
+
+  return node;
+}
+
+
+LazyDocument::LazyDocument()
+  : m_data(nullptr)
+  , m_nodes()
+  , m_arena()
+  , m_values()
+{}
+
+LazyDocument::LazyDocument(LazyDocument&& other) noexcept
+  : m_data(other.m_data)
+  , m_nodes(std::move(other.m_nodes))
+  , m_arena(std::move(other.m_arena))
+  , m_values(std::move(other.m_values))
+{
+  other.clear();
+}
+
+LazyDocument& LazyDocument::operator = (LazyDocument&& other) noexcept
+{
+  if (this != &other) {
+    m_data = other.m_data;
+    m_nodes = std::move(other.m_nodes);
+    m_arena = std::move(other.m_arena);
+    m_values = std::move(other.m_values);
+    other.clear();
+  }
+  return *this;
+}
+
+Parser::ParsingResult LazyDocument::parse(char const* data, size_t size)
+{
+  clear();
+
+  Parser::ParsingResult result = {};
+  result.m_success = buildIndex(data, size, m_nodes);
+  if (result.m_success) {
+    m_data = data;
+    return result;
+  }
+
+  clear();
+  if (std::numeric_limits<uint32_t>::max() < size) {
+    result.m_error.m_kind = ParsingErrorKind::InputTooLarge;
+    return result;
+  }
+
+  // The index does not keep the error details, so the input is parsed
+  // again to find the error position
+  IgnoringHandler handler;
+  Parser parser(data, size);
+  result = parser.parse(handler);
+
+  // The index rejected the input accepted by the parser
+  assert(!result.m_success);
+  if (result.m_success) {
+    result = {};
+    result.m_error.m_kind = ParsingErrorKind::InternalError;
+  }
+  return result;
+}
+
+LazyNode LazyDocument::getRoot() const
+{
+  if (m_nodes.empty()) {
+    return LazyNode();
+  }
+  return LazyNode(this, 0);
+}
+
+LazyNode LazyDocument::findPath(TextView path) const
+{
+  return getRoot().findPath(path);
+}
+
+size_t LazyDocument::getNodeCount() const
+{
+  return m_nodes.size();
+}
+
+void LazyDocument::clear()
+{
+  m_data = nullptr;
+  m_nodes.clear();
+  m_arena.clear();
+  m_values.clear();
+}
+
+bool LazyDocument::buildIndex(char const* data, size_t size,
+  std::vector<Node>& nodes)
+{
+  if (std::numeric_limits<uint32_t>::max() < size) {
+    return false;
+  }
+
+  char const* const end = data + size;
+  char const* current = data;
+  auto getOffset = [&] (char const* position) {
+    return uint32_t(position - data);
+  };
+  auto skipIgnored = [&] {
+    current = scanning::skipIgnored(current, end);
+    return current != end;
+  };
+
+  constexpr char utf8bom[] = "\xEF\xBB\xBF";
+  if ((3 <= size) && (std::memcmp(data, utf8bom, 3) == 0)) {
+    current += 3;
+  }
+
+  if (!skipIgnored() || (*current != '{')) {
+    return false;
+  }
+  ++current;
+  nodes.push_back({ 0, 0, 0, 0, 0, Section });
+
+  // Open sections, each with its last child index or 0
+  struct OpenSection {
+    uint32_t m_node;
+    uint32_t m_lastChild;
+  };
+  std::vector<OpenSection> sections = { { 0, 0 } };
+
+  enum class Expected {
+    EntryOrEnd,
+    Entry,
+    SeparatorOrEnd
+  };
+  Expected expected = Expected::EntryOrEnd;
+
+  while (true) {
+    if (!skipIgnored()) {
+      return false;
+    }
+
+    if ((expected != Expected::Entry) && (*current == '}')) {
+      ++current;
+      sections.pop_back();
+      if (sections.empty()) {
+        return true;
+      }
+      expected = Expected::SeparatorOrEnd;
+      continue;
+    }
+
+    if (expected == Expected::SeparatorOrEnd) {
+      if (*current != ',') {
+        return false;
+      }
+      ++current;
+      expected = Expected::Entry;
+      continue;
+    }
+
+    Node node = {};
+    node.m_key = getOffset(current);
+    current = std::find_if_not(current, end, [] (char c) {
+      return char_classes::is(c, char_classes::KeyChar);
+    });
+    node.m_keySize = getOffset(current) - node.m_key;
+    if ((node.m_keySize == 0) || !skipIgnored() || (*current != ':')) {
+      return false;
+    }
+    ++current;
+    if (!skipIgnored()) {
+      return false;
+    }
+
+    uint32_t const index = uint32_t(nodes.size());
+    OpenSection& parent = sections.back();
+    if (parent.m_lastChild != 0) {
+      nodes[parent.m_lastChild].m_next = index;
+    }
+    parent.m_lastChild = index;
+    ++nodes[parent.m_node].m_valueSize;
+
+    if (*current == '{') {
+      if (sections.size() == Parser::s_maxSectionDepth) {
+        return false;
+      }
+      ++current;
+      node.m_flags = Section;
+      nodes.push_back(node);
+      sections.push_back({ index, 0 });
+      expected = Expected::EntryOrEnd;
+      continue;
+    }
+
+    if (*current != '"') {
+      return false;
+    }
+    ++current;
+    node.m_value = getOffset(current);
+    while (true) {
+      current = scanning::findValueSpecial(current, end);
+      if (current == end) {
+        return false;
+      } else if (*current == '"') {
+        break;
+      } else if (*current == '\\') {
+        node.m_flags |= Escaped;
+        current = skipEscape(current + 1, end);
+        if (!current) {
+          return false;
+        }
+      } else {
+        return false;
+      }
+    }
+    node.m_valueSize = getOffset(current) - node.m_value;
+    ++current;
+
+    nodes.push_back(node);
+    expected = Expected::SeparatorOrEnd;
+  }
+}
+
+} // namespace parsing
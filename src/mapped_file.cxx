@@ -0,0 +1,147 @@
+#include "mapped_file.hxx"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PARSING_HAS_MMAP 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define PARSING_HAS_MMAP 0
+#include <fstream>
+#include <iterator>
+#endif
+
+
+namespace parsing {
+
+MappedFile::MappedFile()
+  : m_mapping(nullptr)
+  , m_mappingSize(0)
+  , m_buffer()
+{}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+#if PARSING_HAS_MMAP
+
+bool MappedFile::open(std::string const& path)
+{
+  close();
+
+  int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  // Empty regular files can not be mapped, and files like procfs entries
+  // report zero size, so they are read as special files.
+  bool result = false;
+  if (S_ISREG(info.st_mode) && (0 < info.st_size)) {
+    size_t const size = static_cast<size_t>(info.st_size);
+    void* const mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE,
+      fd, 0);
+    if (mapping != MAP_FAILED) {
+      ::madvise(mapping, size, MADV_SEQUENTIAL);
+      m_mapping = mapping;
+      m_mappingSize = size;
+      result = true;
+    } else {
+      result = readAll(fd);
+    }
+  } else {
+    result = readAll(fd);
+  }
+
+  ::close(fd);
+  return result;
+}
+
+void MappedFile::close()
+{
+  if (m_mapping) {
+    ::munmap(m_mapping, m_mappingSize);
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+  }
+  m_buffer.clear();
+}
+
+bool MappedFile::readAll(int fd)
+{
+  constexpr size_t chunkSize = 64 * 1024;
+
+  m_buffer.clear();
+  while (true) {
+    size_t const offset = m_buffer.size();
+    m_buffer.resize(offset + chunkSize);
+    ssize_t const count = ::read(fd, &m_buffer[offset], chunkSize);
+    if ((count < 0) && (errno == EINTR)) {
+      m_buffer.resize(offset);
+      continue;
+    }
+    if (count < 0) {
+      m_buffer.clear();
+      return false;
+    }
+    m_buffer.resize(offset + static_cast<size_t>(count));
+    if (count == 0) {
+      return true;
+    }
+  }
+}
+
+#else // PARSING_HAS_MMAP
+
+bool MappedFile::open(std::string const& path)
+{
+  close();
+
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  m_buffer.assign(std::istreambuf_iterator<char>(file),
+    std::istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+void MappedFile::close()
+{
+  m_buffer.clear();
+}
+
+bool MappedFile::readAll(int)
+{
+  return false;
+}
+
+#endif // PARSING_HAS_MMAP
+
+char const* MappedFile::getData() const
+{
+  if (m_mapping) {
+    return static_cast<char const*>(m_mapping);
+  }
+  return m_buffer.data();
+}
+
+size_t MappedFile::getSize() const
+{
+  if (m_mapping) {
+    return m_mappingSize;
+  }
+  return m_buffer.size();
+}
+
+} // namespace parsing
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace parsing {
+
+// Read-only view of a file contents.
+//
+// Regular files are memory-mapped, so the contents are read straight from
+// the page cache. Special files (pipes, character devices, procfs entries)
+// can not be mapped and are read into an owned buffer instead.
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator = (MappedFile const&) = delete;
+
+  bool open(std::string const& path);
+  void close();
+
+  char const* getData() const;
+  size_t getSize() const;
+
+private:
+  bool readAll(int fd);
+
+  void* m_mapping;
+  size_t m_mappingSize;
+  std::string m_buffer;
+};
+
+} // namespace parsing
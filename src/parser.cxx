@@ -1,47 +1,130 @@
 #include "parser.hxx"
+#include "char_classes.hxx"
+#include "key_pool.hxx"
+#include "mapped_file.hxx"
+#include "projection.hxx"
+#include "scanning.hxx"
+#include "thread_pool.hxx"
 
 #include <algorithm>
 #include <array>
-#include <exception>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
 #include <iterator>
-#include <locale>
 #include <map>
-#include <numeric>
-#include <stack>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 
 namespace parsing {
 
-class Exception : public std::exception {
-public:
-  Exception(std::string const& message = "");
 
-  char const* what() const noexcept override;
-protected:
-  std::string m_message;
-};
+TextView::TextView()
+  : m_data(nullptr)
+  , m_size(0)
+{}
+
+TextView::TextView(char const* data, size_t size)
+  : m_data(data)
+  , m_size(size)
+{}
+
+TextView::TextView(std::string const& text)
+  : m_data(text.data())
+  , m_size(text.size())
+{}
 
-Exception::Exception(std::string const& message)
-  : m_message(message)
+TextView::TextView(char const* text)
+  : m_data(text)
+  , m_size(std::char_traits<char>::length(text))
 {}
 
-char const* Exception::what() const noexcept
+char const* TextView::getData() const
+{
+  return m_data;
+}
+
+size_t TextView::getSize() const
+{
+  return m_size;
+}
+
+bool TextView::isEmpty() const
+{
+  return m_size == 0;
+}
+
+TextView::const_iterator TextView::begin() const
+{
+  return m_data;
+}
+
+TextView::const_iterator TextView::end() const
+{
+  return m_data + m_size;
+}
+
+std::string TextView::toString() const
+{
+  return std::string(m_data, m_size);
+}
+
+bool operator == (TextView const& a, TextView const& b)
+{
+  return (a.m_size == b.m_size) && std::equal(a.begin(), a.end(), b.begin());
+}
+
+bool operator != (TextView const& a, TextView const& b)
+{
+  return !(a == b);
+}
+
+bool operator < (TextView const& a, TextView const& b)
+{
+  return std::lexicographical_compare(a.begin(), a.end(),
+    b.begin(), b.end());
+}
+
+bool operator == (std::string const& a, TextView const& b)
+{
+  return TextView(a) == b;
+}
+
+bool operator == (TextView const& a, std::string const& b)
+{
+  return a == TextView(b);
+}
+
+std::ostream& operator << (std::ostream& os, TextView const& text)
 {
-  return m_message.c_str();
+  return os.write(text.getData(), text.getSize());
 }
 
 
 Token::Token()
   : m_kind(TokenKind::Unknown)
-  , m_value()
+  , m_owning(false)
+  , m_view()
+  , m_storage()
 {}
 
-Token::Token(TokenKind kind, std::string const& value)
+Token::Token(TokenKind kind, std::string value)
   : m_kind(kind)
-  , m_value(value)
+  , m_owning(true)
+  , m_view()
+  , m_storage(std::move(value))
+{}
+
+Token::Token(TokenKind kind, TextView value)
+  : m_kind(kind)
+  , m_owning(false)
+  , m_view(value)
+  , m_storage()
 {}
 
 Token::operator bool() const
@@ -54,14 +137,22 @@ TokenKind const& Token::getKind() const
   return m_kind;
 }
 
-Token::ValueType const& Token::getText() const
+Token::ValueType Token::getText() const
+{
+  if (m_owning) {
+    return m_storage;
+  }
+  return m_view;
+}
+
+bool Token::isOwning() const
 {
-  return m_value;
+  return m_owning;
 }
 
 bool operator == (std::string const& a, Token const& b)
 {
-  return (b.m_kind == TokenKind::Value) && (a == b.m_value);
+  return (b.m_kind == TokenKind::Value) && (a == b.getText());
 }
 
 bool operator == (Token const& a, std::string const& b)
@@ -83,52 +174,80 @@ bool operator == (TokenKind const& a, Token const& b)
 struct Lexer::impl {
   static Token readToken(Lexer& lexer)
   {
-    if (lexer.getPosition() == 0) {
-      skipBom(lexer);
+    if ((lexer.getPosition() == 0) && !skipBom(lexer)) {
+      return fail(lexer, LexingErrorKind::WrongBom);
     }
 
     skipIgnored(lexer);
 
-    if (!lexer.m_stream.good()) {
-      if (lexer.m_stream.eof()) {
-        return { TokenKind::ParseEnd, "" };
-      } else {
-        fail("Input stream error");
-      }
-    }
-
-    if (check(lexer, s_sectionBegin)) {
-      return readSectionBegin(lexer);
-    } else if (checkIsKey(lexer)) {
-      return readKey(lexer);
-    } else if (check(lexer, s_keySeparator)) {
-      return readKeySeparator(lexer);
-    } else if (check(lexer, s_entrySeparator)) {
-      return readEntrySeparator(lexer);
-    } else if (check(lexer, s_sectionEnd)) {
-      return readSectionEnd(lexer);
-    } else if (check(lexer, s_valueBegin)) {
-      return readValue(lexer);
-    } else {
-      return { TokenKind::ParseError, "Syntax error" };
+    if (isEnd(lexer)) {
+      if (isStreamFailed(lexer)) {
+        return fail(lexer, LexingErrorKind::InputReadError);
+      }
+      return { TokenKind::ParseEnd, TextView() };
+    }
+
+    using char_classes::Lead;
+    switch (char_classes::getLead(*lexer.m_current)) {
+      case Lead::SectionBegin:
+        return readSectionBegin(lexer);
+      case Lead::Key:
+        return readKey(lexer);
+      case Lead::KeyValueSeparator:
+        return readKeySeparator(lexer);
+      case Lead::EntrySeparator:
+        return readEntrySeparator(lexer);
+      case Lead::SectionEnd:
+        return readSectionEnd(lexer);
+      case Lead::Value:
+        return readValue(lexer);
+      case Lead::Ignored:
+      case Lead::Other:
+        break;
+      // no default for warning
     }
+    return fail(lexer, LexingErrorKind::UnexpectedSymbol);
   }
 
-  static bool checkIsKey(Lexer& lexer)
+  static void skipIgnored(Lexer& lexer)
   {
-    return isKeyBeginner(lexer.peekChar());
+    do {
+      // Tokens are mostly separated by a few bytes, so the bulk kernel
+      // is called only if there is something to skip
+      if ((lexer.m_current != lexer.m_end) &&
+          !scanning::isIgnored(*lexer.m_current))
+      {
+        return;
+      }
+      char const* const runBegin = lexer.m_current;
+      lexer.m_current =
+        scanning::skipIgnored(lexer.m_current, lexer.m_end);
+      countLines(lexer, runBegin, lexer.m_current);
+    } while ((lexer.m_current == lexer.m_end) && refill(lexer));
   }
 
-  static void skipIgnored(Lexer& lexer)
+  // Line ends are control characters, which may only be ignored, so
+  // lines are counted in the skipped runs and the token reading does
+  // not track them
+  static void countLines(Lexer& lexer, char const* begin, char const* end)
   {
-    char symbol = lexer.peekChar();
-    while (isIgnored(symbol)) {
-      lexer.getChar();
-      symbol = lexer.peekChar();
+    char const* lineBegin = nullptr;
+    size_t line = lexer.m_line;
+    for (char const* current = begin; current != end; ++current) {
+      if (*current == '\n') {
+        ++line;
+        lineBegin = current + 1;
+      }
+    }
+
+    if (lineBegin) {
+      lexer.m_line = line;
+      lexer.m_lineBegin = lexer.m_offset + size_t(lineBegin - lexer.m_begin);
     }
   }
 
-  static void skipBom(Lexer& lexer)
+  // Returns false if the BOM is incomplete
+  static bool skipBom(Lexer& lexer)
   {
     constexpr char utf8bom[] = {
       static_cast<char>(0xEF),
@@ -136,30 +255,121 @@ struct Lexer::impl {
       static_cast<char>(0xBF)
     };
 
-    if (check(lexer, utf8bom[0])) {
-      lexer.getChar();
-      expect(lexer, { utf8bom[1], utf8bom[2] }, "Wrong BOM");
+    if (!check(lexer, utf8bom[0])) {
+      return true;
     }
+    lexer.getChar();
+    return skip(lexer, { utf8bom[1], utf8bom[2] });
+  }
+
+  // Returns the storage for decoded token texts. The storage is recycled
+  // from the previous token, so the steady state lexing does not allocate.
+  static std::string takeBuffer(Lexer& lexer)
+  {
+    std::string buffer = std::move(lexer.m_buffer);
+    buffer.clear();
+    return buffer;
+  }
+
+  static bool isKeyChar(char c)
+  {
+    return char_classes::is(c, char_classes::KeyChar);
+  }
+
+  static bool isEnd(Lexer& lexer)
+  {
+    return (lexer.m_current == lexer.m_end) && !refill(lexer);
   }
 
-  static bool isIgnored(char c)
+  // Checks if the stream has failed rather than ended
+  static bool isStreamFailed(Lexer const& lexer)
   {
-    return std::isspace(c, s_cLocale)
-        || std::iscntrl(c, s_cLocale);
+    return lexer.m_stream &&
+      !lexer.m_stream->good() && !lexer.m_stream->eof();
+  }
+
+  // Reads the next portion of the stream input into the chunk buffer.
+  // Unconsumed bytes are moved to the chunk beginning, so lookahead
+  // never spans two chunks. Returns false if no more data was read.
+  // Failed streams are not read.
+  static bool refill(Lexer& lexer)
+  {
+    if (!lexer.m_stream) {
+      return false;
+    }
+
+    std::streambuf* const streamBuffer = lexer.m_stream->rdbuf();
+    if (!streamBuffer || !lexer.m_stream->good()) {
+      return false;
+    }
+
+    if (lexer.m_chunk.empty()) {
+      lexer.m_chunk.resize(s_chunkSize);
+      lexer.m_begin = lexer.m_chunk.data();
+      lexer.m_current = lexer.m_begin;
+      lexer.m_end = lexer.m_begin;
+    }
+
+    size_t const kept = lexer.m_end - lexer.m_current;
+    lexer.m_offset += lexer.m_current - lexer.m_begin;
+    std::copy(lexer.m_current, lexer.m_end, lexer.m_chunk.data());
+    lexer.m_begin = lexer.m_chunk.data();
+    lexer.m_current = lexer.m_begin;
+    lexer.m_end = lexer.m_begin + kept;
+
+    // Take everything the stream buffer already holds, but never block
+    // for more than it can give at once: pipes and sockets deliver data
+    // in portions. A throwing stream buffer fails the stream, as in
+    // the stream input functions.
+    using traits = std::istream::traits_type;
+    std::streamsize count = 0;
+    bool isAtEnd = false;
+    try {
+      std::streamsize available = streamBuffer->in_avail();
+      if (available <= 0) {
+        isAtEnd = (available < 0) ||
+          traits::eq_int_type(streamBuffer->sgetc(), traits::eof());
+        available = std::max<std::streamsize>(streamBuffer->in_avail(), 1);
+      }
+
+      if (!isAtEnd) {
+        std::streamsize const space = lexer.m_chunk.size() - kept;
+        count = streamBuffer->sgetn(lexer.m_chunk.data() + kept,
+          std::min(available, space));
+      }
+    } catch (...) {
+      lexer.m_stream->setstate(std::ios::badbit);
+      return false;
+    }
+
+    if (isAtEnd) {
+      lexer.m_stream->setstate(std::ios::eofbit);
+      return false;
+    }
+    lexer.m_end += count;
+    return 0 < count;
   }
 
-  static bool isKeyBeginner(char c)
+  // Makes at least 'count' bytes available for lookahead, if the input
+  // has them.
+  static bool ensure(Lexer& lexer, size_t count)
   {
-    return std::isalpha(c, s_cLocale)
-        || std::isdigit(c, s_cLocale)
-        || (c == '_');
+    while (size_t(lexer.m_end - lexer.m_current) < count) {
+      if (!refill(lexer)) {
+        return false;
+      }
+    }
+    return true;
   }
 
   using CodePoint = int;
   static_assert(4 <= sizeof(CodePoint),
     "Target platform has too narrow 'int' type");
 
+  static constexpr CodePoint s_invalidCodepoint = -1;
+
   // Make UTF-8 code point from escape sequence of 4 hex digits like '0xFFFF'.
+  // Returns s_invalidCodepoint if there is a wrong digit.
   static CodePoint makeCodepoint(std::array<char, 4> const& escapeSequence)
   {
     using EscapeSequenceType = std::decay_t<decltype(escapeSequence)>;
@@ -181,72 +391,80 @@ struct Lexer::impl {
       } else if (('A' <= digit) && (digit <= 'F')) {
         codepoint += ((10 + digit - int('A')) << power);
       } else {
-        fail("Unexpected symbol found in escape sequence");
+        return s_invalidCodepoint;
       }
     }
 
-    if (((0x0000 <= codepoint) && (codepoint <= 0xFFFF)) == false) {
-      fail("Wrong escaped codepoint");
-    }
-
     return codepoint;
   }
 
-  static std::initializer_list<char> makeCodeunits(CodePoint codepoint)
+  static void appendCodeunits(std::string& buffer, CodePoint codepoint)
   {
     if (codepoint < 0x80) {
       // 1-byte characters: 0xxxxxxx (ASCII)
-      return {
+      buffer.append({
         static_cast<char>(codepoint)
-      };
+      });
     } else if (codepoint <= 0x7FF) {
       // 2-byte characters: 110xxxxx 10xxxxxx
-      return {
+      buffer.append({
         static_cast<char>(0xC0 | (codepoint >> 6)),
         static_cast<char>(0x80 | (codepoint & 0x3F))
-      };
+      });
     } else if (codepoint <= 0xFFFF) {
       // 3-byte characters: 1110xxxx 10xxxxxx 10xxxxxx
-      return {
+      buffer.append({
         static_cast<char>(0xE0 | (codepoint >> 12)),
         static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)),
         static_cast<char>(0x80 | (codepoint & 0x3F))
-      };
+      });
     } else {
       // 4-byte characters: 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
-      return {
+      buffer.append({
         static_cast<char>(0xF0 | (codepoint >> 18)),
         static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)),
         static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)),
         static_cast<char>(0x80 | (codepoint & 0x3F))
-      };
+      });
     }
   }
 
   static Token readKey(Lexer& lexer)
   {
-    auto isKeyInternal = [&] (char c) {
-      return std::isalpha(c, s_cLocale)
-        || std::isdigit(c, s_cLocale)
-        || (c == '_');
-    };
+    // Stream input chunks are reused, so only keys from the buffer input
+    // can be referenced.
+    std::string buffer = lexer.m_stream ? takeBuffer(lexer) : std::string();
+    while (true) {
+      char const* const keyBegin = lexer.m_current;
+      char const* const keyEnd =
+        std::find_if_not(keyBegin, lexer.m_end, isKeyChar);
+      lexer.m_current = keyEnd;
+
+      if (keyEnd != lexer.m_end) {
+        if (!char_classes::is(*keyEnd, char_classes::KeyEnd)) {
+          return fail(lexer, LexingErrorKind::UnexpectedKeySymbol);
+        }
+        if (!lexer.m_stream) {
+          return { TokenKind::Key, TextView(keyBegin, keyEnd - keyBegin) };
+        }
+        buffer.append(keyBegin, keyEnd);
+        return { TokenKind::Key, std::move(buffer) };
+      }
 
-    std::string buffer;
-    char c = lexer.peekChar();
-    while ((c != s_keySeparator) && !isIgnored(c)) {
-      if (!isKeyInternal(c)) {
-        fail("Unexpected symbol found in key");
+      buffer.append(keyBegin, keyEnd);
+      if (!refill(lexer)) {
+        return fail(lexer, LexingErrorKind::UnexpectedDataEnd);
       }
-      buffer.append({ c });
-      lexer.getChar();
-      c = lexer.peekChar();
     }
-    return { TokenKind::Key, std::move(buffer) };
   }
 
+  // Returns s_invalidCodepoint if the sequence is wrong or incomplete
   static CodePoint readEscapedCodepoint(Lexer& lexer)
   {
     std::array<char, 4> escapeSequence = { 0 };
+    if (!ensure(lexer, escapeSequence.size())) {
+      return s_invalidCodepoint;
+    }
     for (char& elem : escapeSequence) {
       elem = lexer.getChar();
     }
@@ -268,127 +486,193 @@ struct Lexer::impl {
     return (codepoint1 << 10) + codepoint2 - 0x35FDC00;
   }
 
+  // Decodes the escape sequence after the escape character
+  static LexingErrorKind readEscaped(Lexer& lexer, std::string& buffer)
+  {
+    if (check(lexer, 'n')) {
+      lexer.getChar();
+      buffer.push_back('\n');
+      return LexingErrorKind::None;
+    } else if (check(lexer, 'r')) {
+      lexer.getChar();
+      buffer.push_back('\r');
+      return LexingErrorKind::None;
+    } else if (check(lexer, s_escape)) {
+      lexer.getChar();
+      buffer.push_back(s_escape);
+      return LexingErrorKind::None;
+    } else if (!check(lexer, 'x')) {
+      return LexingErrorKind::UnknownEscapeSequence;
+    }
+
+    lexer.getChar();
+    CodePoint codepoint = readEscapedCodepoint(lexer);
+    if (codepoint == s_invalidCodepoint) {
+      return LexingErrorKind::WrongEscapeSequence;
+    }
+    if (isHighSurrogate(codepoint)) {
+      CodePoint const highSurrogate = codepoint;
+
+      if (!skip(lexer, { s_escape, 'x' })) {
+        return LexingErrorKind::ExpectedLowSurrogate;
+      }
+      CodePoint const lowSurrogate = readEscapedCodepoint(lexer);
+      if (!isLowSurrogate(lowSurrogate)) {
+        return LexingErrorKind::WrongLowSurrogate;
+      }
+      codepoint = makeSurrogate(highSurrogate, lowSurrogate);
+    }
+    appendCodeunits(buffer, codepoint);
+    return LexingErrorKind::None;
+  }
+
+  // Decodes the escape sequences at the current position available
+  // in memory in bulk. Returns false if there is none, so the sequence
+  // is split by the chunk end or wrong.
+  static bool decodeEscapes(Lexer& lexer, std::string& buffer)
+  {
+    // Runs are decoded by windows to the stack, so the buffer is not
+    // resized ahead. Decoded texts are not longer than escaped ones.
+    constexpr ptrdiff_t window = 64;
+    char decoded[window];
+    char const* const end =
+      lexer.m_current + std::min(window, lexer.m_end - lexer.m_current);
+
+    scanning::DecodedEscapes const result =
+      scanning::decodeEscapes(lexer.m_current, end, decoded);
+    if (result.m_input == lexer.m_current) {
+      return false;
+    }
+    buffer.append(decoded, size_t(result.m_output - decoded));
+    lexer.m_current = result.m_input;
+    return true;
+  }
+
   static Token readValue(Lexer& lexer)
   {
-    auto readEscaped = [&] () -> std::string {
-      if (check(lexer, 'n')) {
-        lexer.getChar();
-        return { '\n' };
-      } else if (check(lexer, 'r')) {
-        lexer.getChar();
-        return { '\r' };
-      } else if (check(lexer, s_escape)) {
-        lexer.getChar();
-        return { s_escape };
-      } else if (check(lexer, 'x')) {
-        lexer.getChar();
-        CodePoint codepoint = readEscapedCodepoint(lexer);
-        if (isHighSurrogate(codepoint)) {
-          CodePoint const highSurrogate = codepoint;
-
-          expect(lexer, { s_escape, 'x' }, "Expected low surrogate in pair");
-          CodePoint const lowSurrogate = readEscapedCodepoint(lexer);
-          if (!isLowSurrogate(lowSurrogate)) {
-            fail("Wrong low surrogate in pair");
+    if (!skip(lexer, s_valueBegin)) {
+      return fail(lexer, LexingErrorKind::UnexpectedSymbol);
+    }
+
+    // Values without escape sequences are referenced in place
+    if (!lexer.m_stream) {
+      char const* const valueBegin = lexer.m_current;
+      char const* const valueEnd =
+        scanning::findValueSpecial(valueBegin, lexer.m_end);
+      if ((valueEnd != lexer.m_end) && (*valueEnd == s_valueEnd)) {
+        if (lexer.m_validateUtf8) {
+          char const* const invalid =
+            scanning::findInvalidUtf8(valueBegin, valueEnd);
+          if (invalid != valueEnd) {
+            lexer.m_current = invalid;
+            return fail(lexer, LexingErrorKind::InvalidUtf8);
           }
-          codepoint = makeSurrogate(highSurrogate, lowSurrogate);
         }
-        return makeCodeunits(codepoint);
+        lexer.m_current = valueEnd + 1;
+        return { TokenKind::Value,
+          TextView(valueBegin, valueEnd - valueBegin) };
       }
+    }
 
-      fail("Unknown escape sequence");
-    };
-
-    auto readUnescaped = [&] () -> char {
-      char const c = lexer.peekChar();
-      if (std::iscntrl(c, s_cLocale)) {
-        fail("Unexpected character");
+    std::string buffer = takeBuffer(lexer);
+    while (true) {
+      // Bulk-copy the run of plain characters available in memory
+      char const* const runEnd =
+        scanning::findValueSpecial(lexer.m_current, lexer.m_end);
+      buffer.append(lexer.m_current, runEnd);
+      lexer.m_current = runEnd;
+
+      if (lexer.m_current == lexer.m_end) {
+        if (!refill(lexer)) {
+          return fail(lexer, LexingErrorKind::UnexpectedDataEnd);
+        }
+        continue;
       }
-      lexer.getChar();
-      // TODO: check for overlong UTF-8 sequences
-      return c;
-    };
-
-    expect(lexer, s_valueBegin, "Expected value");
 
-    std::string buffer;
-    char c = lexer.peekChar();
-    while (c != s_valueEnd) {
-      if (check(lexer, s_escape)) {
-        lexer.getChar();
-        buffer.append(readEscaped());
+      char const c = *lexer.m_current;
+      if (c == s_valueEnd) {
+        break;
+      } else if (c == s_escape) {
+        if (decodeEscapes(lexer, buffer)) {
+          continue;
+        }
+        ++lexer.m_current;
+        LexingErrorKind const error = readEscaped(lexer, buffer);
+        if (error != LexingErrorKind::None) {
+          return fail(lexer, error);
+        }
       } else {
-        buffer.append({ readUnescaped() });
+        return fail(lexer, LexingErrorKind::UnexpectedValueSymbol);
       }
-      c = lexer.peekChar();
     }
-    lexer.getChar();
+    ++lexer.m_current;
+
+    // Sequences may be split by the stream chunks, so the decoded text
+    // is checked. Decoded escapes are valid, so they are checked again
+    // with no harm.
+    if (lexer.m_validateUtf8 &&
+        (scanning::findInvalidUtf8(buffer.data(),
+          buffer.data() + buffer.size()) != buffer.data() + buffer.size()))
+    {
+      return fail(lexer, LexingErrorKind::InvalidUtf8);
+    }
 
     return { TokenKind::Value, std::move(buffer) };
   }
 
+  // Reads the single character token
+  static Token readSymbol(Lexer& lexer, TokenKind kind, char const& symbol)
+  {
+    if (!skip(lexer, symbol)) {
+      return fail(lexer, LexingErrorKind::UnexpectedSymbol);
+    }
+    return { kind, TextView(&symbol, 1) };
+  }
+
   static Token readSectionBegin(Lexer& lexer)
   {
-    expect(lexer, s_sectionBegin, "Expected section begin");
-    return { TokenKind::SectionBegin, { s_sectionBegin } };
+    return readSymbol(lexer, TokenKind::SectionBegin, s_sectionBegin);
   }
 
   static Token readSectionEnd(Lexer& lexer)
   {
-    expect(lexer, s_sectionEnd, "Expected section end");
-    return { TokenKind::SectionEnd, { s_sectionEnd } };
+    return readSymbol(lexer, TokenKind::SectionEnd, s_sectionEnd);
   }
 
   static Token readKeySeparator(Lexer& lexer)
   {
-    expect(lexer, s_keySeparator, "Expected key separator");
-    return { TokenKind::KeyValueSeparator, { s_keySeparator } };
+    return readSymbol(lexer, TokenKind::KeyValueSeparator, s_keySeparator);
   }
 
   static Token readEntrySeparator(Lexer& lexer)
   {
-    expect(lexer, s_entrySeparator, "Expected entry separator");
-    return { TokenKind::EntrySeparator, { s_entrySeparator } };
+    return readSymbol(lexer, TokenKind::EntrySeparator, s_entrySeparator);
   }
 
 
-  static void expect(Lexer& lexer, std::string const& expected,
-    char const* failMessage)
+  // Skips the expected characters. Returns false if they are not found.
+  static bool skip(Lexer& lexer, std::string const& expected)
   {
     if (!check(lexer, expected)) {
-      fail(failMessage);
-    }
-    for (size_t i = 0; i != expected.size(); ++i) {
-      lexer.getChar();
+      return false;
     }
+    lexer.m_current += expected.size();
+    return true;
   }
 
-  static void expect(Lexer& lexer, char expected,
-    char const* failMessage)
+  static bool skip(Lexer& lexer, char expected)
   {
     if (!check(lexer, expected)) {
-      fail(failMessage);
+      return false;
     }
     lexer.getChar();
+    return true;
   }
 
   static bool check(Lexer& lexer, std::string const& expected)
   {
-    auto startPos = lexer.m_stream.tellg();
-
-    auto iExpected = expected.begin();
-    auto const iExpectedEnd = expected.end();
-    char c = lexer.peekChar();
-    while ((iExpected != iExpectedEnd) && (c == *iExpected)) {
-        ++iExpected;
-        lexer.getChar();
-        c = lexer.peekChar();
-    }
-    bool const result = iExpected == iExpectedEnd;
-
-    lexer.m_stream.seekg(startPos);
-
-    return result;
+    return ensure(lexer, expected.size())
+      && std::equal(expected.begin(), expected.end(), lexer.m_current);
   }
 
   static bool check(Lexer& lexer, char expected)
@@ -396,14 +680,53 @@ struct Lexer::impl {
     return lexer.peekChar() == expected;
   }
 
-  [[noreturn]]
-  static void fail(std::string const& message)
+  // Records the error and makes the error token. The token text
+  // is the static error description, the full message is built
+  // only on request.
+  static Token fail(Lexer& lexer, LexingErrorKind error)
+  {
+    // Tokens cut by a stream failure are reported as the read error
+    if (isStreamFailed(lexer)) {
+      error = LexingErrorKind::InputReadError;
+    }
+    lexer.m_error = error;
+    lexer.m_errorPosition = lexer.getPosition();
+    return { TokenKind::ParseError, TextView(getDescription(error)) };
+  }
+
+  static char const* getDescription(LexingErrorKind error)
   {
-    throw Exception(message);
+    switch (error) {
+      case LexingErrorKind::None:
+        return "";
+      case LexingErrorKind::UnexpectedDataEnd:
+        return "Unexpected end of data";
+      case LexingErrorKind::InputReadError:
+        return "Input stream error";
+      case LexingErrorKind::WrongBom:
+        return "Wrong BOM";
+      case LexingErrorKind::UnexpectedSymbol:
+        return "Syntax error";
+      case LexingErrorKind::UnexpectedKeySymbol:
+        return "Unexpected symbol found in key";
+      case LexingErrorKind::UnexpectedValueSymbol:
+        return "Unexpected character";
+      case LexingErrorKind::UnknownEscapeSequence:
+        return "Unknown escape sequence";
+      case LexingErrorKind::WrongEscapeSequence:
+        return "Unexpected symbol found in escape sequence";
+      case LexingErrorKind::ExpectedLowSurrogate:
+        return "Expected low surrogate in pair";
+      case LexingErrorKind::WrongLowSurrogate:
+        return "Wrong low surrogate in pair";
+      case LexingErrorKind::InvalidUtf8:
+        return "Invalid UTF-8 sequence";
+      // no default for warning
+    }
+    return "";
   }
 
 
-  static std::locale const s_cLocale;
   static constexpr char s_keySeparator = ':';
   static constexpr char s_entrySeparator = ',';
   static constexpr char s_sectionBegin = '{';
@@ -411,15 +734,68 @@ struct Lexer::impl {
   static constexpr char s_valueBegin = '"';
   static constexpr char s_valueEnd = '"';
   static constexpr char s_escape = '\\';
+
+  // Stream input is read by chunks of this size
+  static constexpr size_t s_chunkSize = 64 * 1024;
 };
 
-std::locale const Lexer::impl::s_cLocale = std::locale();
+constexpr Lexer::impl::CodePoint Lexer::impl::s_invalidCodepoint;
+constexpr char Lexer::impl::s_keySeparator;
+constexpr char Lexer::impl::s_entrySeparator;
+constexpr char Lexer::impl::s_sectionBegin;
+constexpr char Lexer::impl::s_sectionEnd;
 
 Lexer::Lexer(std::istream& is)
-  : m_stream(is)
+  : m_stream(&is)
+  , m_chunk()
+  , m_offset(0)
+  , m_begin(nullptr)
+  , m_current(nullptr)
+  , m_end(nullptr)
+  , m_lastToken()
+  , m_buffer()
+  , m_error(LexingErrorKind::None)
+  , m_errorPosition(0)
+  , m_line(1)
+  , m_lineBegin(0)
+  , m_validateUtf8(false)
+{}
+
+Lexer::Lexer(char const* data, size_t size)
+  : m_stream(nullptr)
+  , m_chunk()
+  , m_offset(0)
+  , m_begin(data)
+  , m_current(data)
+  , m_end(data + size)
   , m_lastToken()
+  , m_buffer()
+  , m_error(LexingErrorKind::None)
+  , m_errorPosition(0)
+  , m_line(1)
+  , m_lineBegin(0)
+  , m_validateUtf8(false)
 {}
 
+void Lexer::reset(char const* data, size_t size, size_t offset)
+{
+  if (m_lastToken.m_owning) {
+    m_buffer.swap(m_lastToken.m_storage);
+  }
+  m_lastToken = Token();
+  m_error = LexingErrorKind::None;
+  if (offset == 0) {
+    m_line = 1;
+    m_lineBegin = 0;
+  }
+
+  m_stream = nullptr;
+  m_offset = offset;
+  m_begin = data;
+  m_current = data;
+  m_end = data + size;
+}
+
 Token const& Lexer::getCurrent()
 {
   if (!m_lastToken && !isFinished()) {
@@ -434,13 +810,11 @@ Token const& Lexer::getNext()
     return m_lastToken;
   }
 
-  try {
-    m_lastToken = impl::readToken(*this);
-  } catch (Exception const& e) {
-    m_lastToken = Token(TokenKind::ParseError,
-      "Parse error at position " + std::to_string(m_stream.tellg()) + ": " +
-      e.what());
+  if (m_lastToken.m_owning) {
+    m_buffer.swap(m_lastToken.m_storage);
   }
+
+  m_lastToken = impl::readToken(*this);
   return m_lastToken;
 }
 
@@ -451,22 +825,53 @@ bool Lexer::isFinished() const
 
 std::istream::pos_type Lexer::getPosition() const
 {
-  return m_stream.tellg();
+  return std::streamoff(m_offset + (m_current - m_begin));
+}
+
+void Lexer::setUtf8Validation(bool enabled)
+{
+  m_validateUtf8 = enabled;
+}
+
+size_t Lexer::getLine() const
+{
+  return m_line;
+}
+
+size_t Lexer::getColumn() const
+{
+  return size_t(std::streamoff(getPosition())) - m_lineBegin + 1;
+}
+
+LexingErrorKind Lexer::getErrorKind() const
+{
+  return m_error;
+}
+
+std::string Lexer::getErrorMessage() const
+{
+  if (m_error == LexingErrorKind::None) {
+    return std::string();
+  }
+  return "Parse error at position " +
+    std::to_string(std::streamoff(m_errorPosition)) + ": " +
+    impl::getDescription(m_error);
 }
 
 char Lexer::getChar()
 {
-  if (m_stream.eof()) {
-    throw Exception("Unexpected end of data");
-  } else if (m_stream.bad()) {
-    throw Exception("Internal stream error");
+  if (impl::isEnd(*this)) {
+    return std::istream::traits_type::eof();
   }
-  return m_stream.get();
+  return *m_current++;
 }
 
-char Lexer::peekChar() const
+char Lexer::peekChar()
 {
-  return m_stream.peek();
+  if (impl::isEnd(*this)) {
+    return std::istream::traits_type::eof();
+  }
+  return *m_current;
 }
 
 
@@ -479,7 +884,7 @@ struct Parser::impl {
   // SectionEnd = '}'
   // Entries = ( Entry NextEntry )?
   // Entry = Key KeyValueSeparator Value
-  // NextEntry = ( EntrySeparator Entry )?
+  // NextEntry = ( EntrySeparator Entry NextEntry )?
   // EntrySeparator = ','
   // Key = key
   // KeyValueSeparator = ':'
@@ -487,374 +892,1231 @@ struct Parser::impl {
   // TextValue = value
 
   // Mapping from decomposed grammar to internal parser states
-  enum class StateKind {
+  enum class StateKind : uint8_t {
+    // nonterminals
     Start = 0,
     Section,
-    SectionBegin,
-    SectionEnd,
+    Entries,
     Entry,
     NextEntry,
-    EntrySeparator,
-    Entries,
-    Key,
     Value,
-    KeyValueSeparator,
-    TextValue
-   };
 
-  // Set of possible token parsing products
-  enum class ProductKind {
+    // terminals
     SectionBegin,
     SectionEnd,
-    Entry,
+    EntrySeparator,
     Key,
-    Value
-  };
-
-  // Token parsing product
-  struct Product {
-    ProductKind m_kind;
-    std::string m_value;
-  };
+    KeyValueSeparator,
+    TextValue,
 
-  // Transition function result
-  enum class ActionKind {
-    Produce, // accept current token and produce some symbols
-    Expect, // accept current token and expect some new tokens
-    Fail // reject current token and return parse error
+    _Count
   };
 
-  // TODO: implement using variant
-  struct Action {
-    ActionKind m_kind;
-
-    struct Fail {
-      ParsingErrorKind m_error;
-      StateKind m_state;
-      TokenKind m_receivedToken;
-      std::istream::pos_type m_position;
-    };
-    struct Produce {
-      std::vector<Product> m_producedSymbols;
-    };
-    struct Expect {
-      std::vector<StateKind> m_expectedProductions;
-    };
+  static constexpr size_t s_stateCount = size_t(StateKind::_Count);
+  static constexpr size_t s_tokenKindCount = size_t(TokenKind::ParseError) + 1;
 
-    Fail m_failure;
-    Produce m_production;
-    Expect m_expectation;
+  // Grammar rule expansions. States are listed in the parsing order.
+  enum class Rule : uint8_t {
+    Empty = 0,
+    Start,
+    Section,
+    Entries,
+    Entry,
+    NextEntry,
+    TextValue,
 
-    static Action expect(std::vector<StateKind> states)
-    {
-      Action action;
-      action.m_kind = ActionKind::Expect;
-      action.m_expectation.m_expectedProductions = std::move(states);
-      return action;
-    }
+    Match, // accept the current token in a terminal state
+    Fail, // reject the current token
 
-    static Action produce(std::vector<Product> products)
-    {
-      Action action;
-      action.m_kind = ActionKind::Produce;
-      action.m_production.m_producedSymbols = std::move(products);
-      return action;
-    }
+    _Count
+  };
 
-    static Action fail(StateKind state, TokenKind receivedToken,
-      std::istream::pos_type position,
-      ParsingErrorKind error = ParsingErrorKind::UnexpectedTokenReceived)
-    {
-      Action action;
-      action.m_kind = ActionKind::Fail;
-      action.m_failure.m_error = error;
-      action.m_failure.m_state = state;
-      action.m_failure.m_position = position;
-      action.m_failure.m_receivedToken = receivedToken;
-      return action;
-    }
+  struct Production {
+    uint8_t m_count;
+    StateKind m_states[3];
   };
 
-  // Transition function
-  static Action doTransition(StateKind const& state, Lexer& lexer)
+  static constexpr Production getProduction(Rule rule)
   {
-    auto check = [&] (TokenKind const& kind) {
-      auto const& token = lexer.getCurrent();
-      return token.getKind() == kind;
-    };
-    auto consume = [&] {
-      auto const current = lexer.getCurrent();
-      lexer.getNext();
-      return current;
-    };
+    switch (rule) {
+      case Rule::Start:
+        return { 1, { StateKind::Section } };
+      case Rule::Section:
+        return { 3, {
+          StateKind::SectionBegin,
+          StateKind::Entries,
+          StateKind::SectionEnd
+        } };
+      case Rule::Entries:
+        return { 2, { StateKind::Entry, StateKind::NextEntry } };
+      case Rule::Entry:
+        return { 3, {
+          StateKind::Key,
+          StateKind::KeyValueSeparator,
+          StateKind::Value
+        } };
+      case Rule::NextEntry:
+        return { 3, {
+          StateKind::EntrySeparator,
+          StateKind::Entry,
+          StateKind::NextEntry
+        } };
+      case Rule::TextValue:
+        return { 1, { StateKind::TextValue } };
+      default:
+        return { 0, {} };
+    }
+  }
 
-    if (check(TokenKind::ParseError)) {
-      return Action::fail(state,
-        lexer.getCurrent().getKind(), lexer.getPosition());
+  // Predictive parsing table: the rule to apply in a state
+  // for the current token
+  static constexpr Rule getRule(StateKind state, TokenKind token)
+  {
+    if (token == TokenKind::ParseError) {
+      return Rule::Fail;
     }
 
     switch (state) {
       case StateKind::Start:
-        return Action::expect({ StateKind::Section });
-        break;
-
+        return Rule::Start;
       case StateKind::Section:
-        return Action::expect({
-          StateKind::SectionBegin,
-          StateKind::Entries,
-          StateKind::SectionEnd
-        });
-        break;
-
-      case StateKind::SectionBegin:
-        if (check(TokenKind::SectionBegin)) {
-          consume();
-          return Action::produce({
-            { ProductKind::SectionBegin, "" }
-          });
-        }
-        break;
-
-      case StateKind::SectionEnd:
-        if (check(TokenKind::SectionEnd)) {
-          consume();
-          return Action::produce({
-            { ProductKind::SectionEnd, "" }
-          });
-        }
-        break;
-
+        return Rule::Section;
       case StateKind::Entries:
-        if (check(TokenKind::Key)) {
-          return Action::expect({ StateKind::Entry, StateKind::NextEntry });
-        } else {
-          return Action::expect({ /* none */ });
-        }
-        break;
-
+        return (token == TokenKind::Key) ? Rule::Entries : Rule::Empty;
       case StateKind::Entry:
-        return Action::expect({
-          StateKind::Key,
-          StateKind::KeyValueSeparator,
-          StateKind::Value
-        });
-        break;
+        return Rule::Entry;
+      case StateKind::NextEntry:
+        return (token == TokenKind::EntrySeparator) ?
+          Rule::NextEntry : Rule::Empty;
+      case StateKind::Value:
+        return (token == TokenKind::Value) ? Rule::TextValue
+          : (token == TokenKind::SectionBegin) ? Rule::Start
+          : Rule::Fail;
 
+      case StateKind::SectionBegin:
+        return (token == TokenKind::SectionBegin) ? Rule::Match : Rule::Fail;
+      case StateKind::SectionEnd:
+        return (token == TokenKind::SectionEnd) ? Rule::Match : Rule::Fail;
+      case StateKind::EntrySeparator:
+        return (token == TokenKind::EntrySeparator) ?
+          Rule::Match : Rule::Fail;
       case StateKind::Key:
-        if (check(TokenKind::Key)) {
-          Token token = consume();
-          return Action::produce({
-            { ProductKind::Entry, "" },
-            { ProductKind::Key, token.getText() }
-          });
-        }
-        break;
-
+        return (token == TokenKind::Key) ? Rule::Match : Rule::Fail;
       case StateKind::KeyValueSeparator:
-        if (check(TokenKind::KeyValueSeparator)) {
-          consume();
-          return Action::produce({ /* none */ });
-        }
+        return (token == TokenKind::KeyValueSeparator) ?
+          Rule::Match : Rule::Fail;
+      case StateKind::TextValue:
+        return (token == TokenKind::Value) ? Rule::Match : Rule::Fail;
 
-      case StateKind::Value:
-        if (check(TokenKind::Value)) {
-          return Action::expect({ StateKind::TextValue });
-        } else if (check(TokenKind::SectionBegin)) {
-          return Action::expect({ StateKind::Section });
-        }
-        break;
+      default:
+        return Rule::Fail;
+    }
+  }
 
-      case StateKind::TextValue:
-        if (check(TokenKind::Value)){
-          auto const token = consume();
-          return Action::produce({
-            { ProductKind::Value, token.getText() }
-          });
+  struct Table {
+    Rule m_rules[s_stateCount][s_tokenKindCount];
+    Production m_productions[size_t(Rule::_Count)];
+  };
+
+  static constexpr Table makeTable()
+  {
+    Table table = {};
+    for (size_t state = 0; state != s_stateCount; ++state) {
+      for (size_t token = 0; token != s_tokenKindCount; ++token) {
+        table.m_rules[state][token] =
+          getRule(StateKind(state), TokenKind(token));
+      }
+    }
+    for (size_t rule = 0; rule != size_t(Rule::_Count); ++rule) {
+      table.m_productions[rule] = getProduction(Rule(rule));
+    }
+    return table;
+  }
+
+  static Table const s_table;
+
+  // Parser state stack size limit. Each open section keeps
+  // at most two states on the stack, plus the innermost entry states,
+  // so the stack does not overflow while the nesting is in the limit.
+  static constexpr size_t s_maxStackSize = 2 * s_maxSectionDepth + 4;
+
+#if defined(PARSER_WITH_STATS)
+  using Clock = std::chrono::steady_clock;
+
+  // Adds the time of the timer life to the duration
+  class PhaseTimer {
+  public:
+    explicit PhaseTimer(ParsingStats::Duration& duration)
+      : m_duration(duration)
+      , m_start(Clock::now())
+    {}
+
+    ~PhaseTimer()
+    {
+      m_duration += std::chrono::duration_cast<ParsingStats::Duration>(
+        Clock::now() - m_start);
+    }
+
+  private:
+    ParsingStats::Duration& m_duration;
+    Clock::time_point const m_start;
+  };
+#endif // PARSER_WITH_STATS
+
+  // Predictive LL(1) parser with a fixed-capacity state stack.
+  // Accepted tokens are reported to the handler immediately.
+  class Driver {
+  public:
+    Driver()
+      : Driver({ StateKind::Start })
+    {}
+
+    // Starts parsing from the states listed in the parsing order,
+    // with the given number of sections already open
+    explicit Driver(std::initializer_list<StateKind> states,
+      size_t depth = 0)
+      : m_size(0)
+      , m_depth(depth)
+      , m_key()
+      , m_partialInput(false)
+    {
+      for (auto iState = states.end(); iState != states.begin(); ) {
+        push(*--iState);
+      }
+    }
+
+    ParsingResult run(Lexer& lexer, ParsingHandler& handler)
+    {
+#if defined(PARSER_WITH_STATS)
+      // Statistics are summed over the runs of the partial input
+      std::streamoff const begin = lexer.getPosition();
+      ParsingResult result;
+      {
+        PhaseTimer timer(m_stats.m_totalTime);
+        result = parseTokens(lexer, handler);
+      }
+      m_stats.m_bytes += size_t(std::streamoff(lexer.getPosition()) - begin);
+      m_stats.m_parsingTime =
+        m_stats.m_totalTime - m_stats.m_lexingTime - m_stats.m_handlingTime;
+      result.m_stats = m_stats;
+      return result;
+#else
+      return parseTokens(lexer, handler);
+#endif
+    }
+
+    // With partial input, parsing is paused at the input end
+    // and continued by the next run
+    void setPartialInput(bool partial)
+    {
+      m_partialInput = partial;
+    }
+
+    bool isFinished() const
+    {
+      return m_size == 0;
+    }
+
+  private:
+    ParsingResult parseTokens(Lexer& lexer, ParsingHandler& handler)
+    {
+      ParsingResult result;
+      result.m_success = true;
+
+      while (m_size != 0) {
+        Token const& token = getCurrent(lexer);
+        if (m_partialInput && (token.getKind() == TokenKind::ParseEnd)) {
+          // The key may reference the input, which is not kept
+          if (!m_key.isOwning()) {
+            m_key = Token(m_key.getKind(), m_key.getText().toString());
+          }
+          return result;
         }
-        break;
 
-      case StateKind::NextEntry:
-        if (check(TokenKind::EntrySeparator)) {
-          return Action::expect({
-            StateKind::EntrySeparator,
-            StateKind::Entry
-          });
+        StateKind const state = m_states[--m_size];
+        Rule const rule =
+          s_table.m_rules[size_t(state)][size_t(token.getKind())];
+
+        if (rule == Rule::Match) {
+          if ((state == StateKind::SectionBegin) &&
+              (m_depth == s_maxSectionDepth))
+          {
+            return fail(result, ParsingErrorKind::NestingTooDeep, lexer);
+          }
+          accept(state, token, handler);
+          moveNext(lexer);
+        } else if (rule == Rule::Fail) {
+          // Input which could not be read is not a wrong token
+          bool const isReadError =
+            (token.getKind() == TokenKind::ParseError) &&
+            (lexer.getErrorKind() == LexingErrorKind::InputReadError);
+          return fail(result, isReadError ?
+            ParsingErrorKind::InputReadError :
+            ParsingErrorKind::UnexpectedTokenReceived, lexer);
         } else {
-          return Action::expect({ /* none */ });
+          Production const& production =
+            s_table.m_productions[size_t(rule)];
+          if (s_maxStackSize - m_size < production.m_count) {
+            return fail(result, ParsingErrorKind::NestingTooDeep, lexer);
+          }
+          for (size_t i = production.m_count; i != 0; --i) {
+            push(production.m_states[i - 1]);
+          }
         }
-        break;
+      }
 
-      case StateKind::EntrySeparator:
-        if (check(TokenKind::EntrySeparator)) {
-          consume();
-          return Action::produce({ /* none */ });
-        }
+      return result;
+    }
 
-      // no default for warning
+    void push(StateKind state)
+    {
+      m_states[m_size++] = state;
     }
 
-    return Action::fail(state,
-      lexer.getCurrent().getKind(), lexer.getPosition());
-  }
+    Token const& getCurrent(Lexer& lexer)
+    {
+#if defined(PARSER_WITH_STATS)
+      PhaseTimer timer(m_stats.m_lexingTime);
+#endif
+      return lexer.getCurrent();
+    }
 
-  // Factory function for errors
-  static ParsingError makeParsingError(Action::Fail const& failure)
-  {
-    ParsingError error;
-    error.m_kind = failure.m_error;
-    error.m_position = failure.m_position;
-    return error;
-  }
+    void moveNext(Lexer& lexer)
+    {
+#if defined(PARSER_WITH_STATS)
+      PhaseTimer timer(m_stats.m_lexingTime);
+#endif
+      lexer.getNext();
+    }
 
-  // Function to create category name in parsed tree
-  static Key join(std::vector<Key> const& parts, std::string const& glue)
-  {
-    size_t const length = std::accumulate(parts.begin(), parts.end(), 0,
-      [&] (auto const& sum, auto const& part) {
-        return sum + part.size() + glue.size();
-      });
-    Key result;
-    result.reserve(length);
-    for (auto iParts = parts.begin(), iPartsEnd = parts.end();
-      iParts != iPartsEnd;)
+    void accept(StateKind state, Token const& token,
+      ParsingHandler& handler)
     {
-      result.append(*iParts);
-      ++iParts;
-      if (iParts != iPartsEnd) {
-        result.append(glue);
+#if defined(PARSER_WITH_STATS)
+      ++m_stats.m_tokenCounts[size_t(token.getKind())];
+      PhaseTimer timer(m_stats.m_handlingTime);
+#endif
+
+      switch (state) {
+        case StateKind::SectionBegin:
+          ++m_depth;
+#if defined(PARSER_WITH_STATS)
+          m_stats.m_maxDepth = std::max(m_stats.m_maxDepth, m_depth);
+#endif
+          handler.onSectionBegin(m_key.getText());
+          break;
+
+        case StateKind::SectionEnd:
+          --m_depth;
+          handler.onSectionEnd();
+          break;
+
+        case StateKind::Key:
+          // Reuses the key storage when the token text is owned
+          m_key = token;
+          break;
+
+        case StateKind::TextValue:
+          handler.onEntry(m_key.getText(), token.getText());
+          break;
+
+        default:
+          break;
       }
     }
-    return result;
-  }
 
-  // Function to create resulting parsing tree
-  static ParsedTree makeOutputTree(std::vector<Product> const& outputSequence)
-  {
-    // NOTE: assuming sequence satisfies grammar
+    ParsingResult& fail(ParsingResult& result, ParsingErrorKind kind,
+      Lexer& lexer)
+    {
+#if defined(PARSER_WITH_STATS)
+      ++m_stats.m_tokenCounts[size_t(getCurrent(lexer).getKind())];
+#endif
+      result.m_success = false;
+      result.m_error.m_kind = kind;
+      result.m_error.m_position = lexer.getPosition();
+      result.m_error.m_line = lexer.getLine();
+      result.m_error.m_column = lexer.getColumn();
+      return result;
+    }
 
-    ParsedTree tree;
+    std::array<StateKind, s_maxStackSize> m_states;
+    size_t m_size;
+    size_t m_depth; // number of open sections
 
-    std::vector<Key> sectionsStack;
-    Key lastKey;
+    // Key of the entry being parsed. Entry values and sections follow it.
+    Token m_key;
 
-    for (auto const& product : outputSequence) {
-      switch (product.m_kind) {
-        case ProductKind::SectionBegin:
-        {
-          if (!lastKey.empty()) {
-            sectionsStack.push_back(lastKey);
-          }
-          if (!sectionsStack.empty()) {
-            auto category = join(sectionsStack, { s_categorySeparator });
-            tree.emplace(std::move(category), "");
-          }
-          break;
-        }
+    bool m_partialInput;
+
+#if defined(PARSER_WITH_STATS)
+    ParsingStats m_stats;
+#endif
+  };
+
+  // Handler building the resulting parsing tree. Tree nodes are
+  // allocated with the allocator of the initial tree. Keys of interned
+  // trees are interned in the pool.
+  template <class Tree>
+  class BasicTreeBuilder : public ParsingHandler {
+  public:
+    explicit BasicTreeBuilder(Tree tree = Tree(), KeyPool* keys = nullptr)
+      : m_tree(std::move(tree))
+      , m_keys(keys)
+    {}
+
+    void onSectionBegin(TextView key) override
+    {
+      // the root section has no key and produces no category
+      ++m_depth;
+      if (m_depth == 1) {
+        return;
+      }
+
+      m_pathLengths.push_back(m_path.size());
+      appendToPath(m_path, key);
+      emplace(m_path, TextView());
+    }
 
-        case ProductKind::SectionEnd:
-          if (!sectionsStack.empty()) {
-            sectionsStack.pop_back();
+    void onSectionEnd() override
+    {
+      --m_depth;
+      if (!m_pathLengths.empty()) {
+        m_path.resize(m_pathLengths.back());
+        m_pathLengths.pop_back();
+      }
+    }
+
+    void onEntry(TextView key, TextView value) override
+    {
+      m_key.assign(m_path);
+      appendToPath(m_key, key);
+      emplace(m_key, value);
+    }
+
+    Tree takeTree()
+    {
+      return std::move(m_tree);
+    }
+
+    // Continues building within the section of the category. The own
+    // entries of the section and of its parents are not added.
+    void enterCategory(Key const& category)
+    {
+      m_depth = 1;
+      m_path.assign(category);
+      m_pathLengths.clear();
+    }
+
+    // Prepares for the next parsing, keeping the allocated buffers
+    void reset()
+    {
+      m_tree.clear();
+      m_depth = 0;
+      m_path.clear();
+      m_pathLengths.clear();
+    }
+
+  private:
+    void emplace(Key const& key, TextView value)
+    {
+      insert(m_tree, key, value);
+    }
+
+    // Constructs the strings in place, so allocator-aware trees
+    // pass their allocator to them
+    template <class StringTree>
+    void insert(StringTree& tree, Key const& key, TextView value)
+    {
+      tree.emplace(std::piecewise_construct,
+        std::forward_as_tuple(key.data(), key.size()),
+        std::forward_as_tuple(value.getData(), value.getSize()));
+    }
+
+    void insert(InternedTree& tree, Key const& key, TextView value)
+    {
+      tree.emplace(std::piecewise_construct,
+        std::forward_as_tuple(m_keys->intern(key)),
+        std::forward_as_tuple(value.getData(), value.getSize()));
+    }
+
+    static void appendToPath(Key& path, TextView key)
+    {
+      if (!path.empty()) {
+        path.push_back(s_categorySeparator);
+      }
+      path.append(key.getData(), key.getSize());
+    }
+
+    Tree m_tree;
+    KeyPool* m_keys;
+
+    size_t m_depth = 0;
+    Key m_path; // category of the current section
+    std::vector<size_t> m_pathLengths; // category lengths of parent sections
+    Key m_key; // buffer for entry keys
+  };
+
+  using TreeBuilder = BasicTreeBuilder<ParsedTree>;
+
+  // Parallel parsing splits the input into chunks of at least this size
+  static constexpr size_t s_minChunkSize = 64 * 1024;
+
+  // Chunks per thread for load balancing of uneven entries
+  static constexpr size_t s_chunksPerThread = 4;
+
+  // Splits the input at the root section entry separators into chunks
+  // of at least the given size. The first chunk starts at the input
+  // beginning, the next ones start at the separators, the last one ends
+  // before the root section end. Values are skipped as a whole: there is
+  // no escape sequence for a quote, so a value ends at the next quote.
+  // Returns false if the root section is not found.
+  static bool splitEntries(char const* data, size_t size,
+    size_t minChunkSize, std::vector<TextView>& chunks)
+  {
+    char const* const end = data + size;
+    char const* chunkBegin = data;
+    char const* current = scanning::findStructural(data, end);
+    if ((current == end) || (*current != '{')) {
+      return false;
+    }
+
+    size_t depth = 0;
+    for (; current != end;
+        current = scanning::findStructural(current + 1, end))
+    {
+      switch (*current) {
+        case '"':
+          current = static_cast<char const*>(
+            std::memchr(current + 1, '"', size_t(end - current - 1)));
+          if (!current) {
+            return false;
           }
           break;
 
-        case ProductKind::Entry:
-          // none
+        case '{':
+          ++depth;
           break;
 
-        case ProductKind::Key:
-          lastKey = product.m_value;
+        case '}':
+          --depth;
+          if (depth == 0) {
+            chunks.emplace_back(chunkBegin, size_t(current - chunkBegin));
+            return true;
+          }
           break;
 
-        case ProductKind::Value:
-        {
-          Key category;
-          if (!sectionsStack.empty()) {
-            category.append(join(sectionsStack, { s_categorySeparator }));
-            category.append({ s_categorySeparator });
+        case ',':
+          if ((depth == 1) &&
+              (minChunkSize <= size_t(current - chunkBegin)))
+          {
+            chunks.emplace_back(chunkBegin, size_t(current - chunkBegin));
+            chunkBegin = current;
           }
-          category.append(lastKey);
-          tree.emplace(std::move(category), product.m_value);
           break;
+
+        default:
+          break;
+      }
+    }
+
+    return false;
+  }
+
+  // Parses a chunk of the root section entries. The first chunk opens
+  // the root section, the next ones continue it from an entry separator.
+  // The chunk is valid only if it is parsed to the end.
+  static ParsingResult parseChunk(TextView chunk, bool isFirst)
+  {
+    Lexer lexer(chunk.getData(), chunk.getSize());
+    TreeBuilder builder;
+
+    ParsingResult result;
+    if (isFirst) {
+      Driver driver({ StateKind::SectionBegin, StateKind::Entries });
+      result = driver.run(lexer, builder);
+    } else {
+      builder.onSectionBegin(TextView());
+      Driver driver({ StateKind::NextEntry }, 1);
+      result = driver.run(lexer, builder);
+    }
+
+    if (result.m_success &&
+        (lexer.getCurrent().getKind() != TokenKind::ParseEnd))
+    {
+      result.m_success = false;
+    }
+    if (result.m_success) {
+      result.m_tree = builder.takeTree();
+    }
+
+    return result;
+  }
+
+#if defined(PARSER_WITH_STATS)
+  // Reads the end of the root section after the last chunk, which
+  // the chunks do not include
+  static ParsingStats parseRootEnd(TextView input)
+  {
+    Lexer lexer(input.getData(), input.getSize());
+    TreeBuilder builder;
+    builder.onSectionBegin(TextView());
+
+    Driver driver({ StateKind::SectionEnd }, 1);
+    return driver.run(lexer, builder).m_stats;
+  }
+#endif
+
+  // Moves the entries of the next tree to the previous one. The first
+  // occurrence of a key is kept, as in the serial parsing.
+  static void mergeTrees(ParsedTree& tree, ParsedTree& next)
+  {
+#if __cplusplus >= 201703L
+    tree.merge(next);
+#else
+    tree.insert(std::make_move_iterator(next.begin()),
+      std::make_move_iterator(next.end()));
+#endif
+    next.clear();
+  }
+
+  // Parses contiguous in-memory data by chunks of the root section
+  // entries on the shared thread pool
+  static ParsingResult parseParallel(char const* data, size_t size,
+    size_t threadCount)
+  {
+    ThreadPool& pool = ThreadPool::getShared();
+    if (threadCount == 0) {
+      threadCount = pool.getWorkerCount() + 1;
+    }
+
+    std::vector<TextView> chunks;
+    size_t const chunkSize = std::max(s_minChunkSize,
+      size / (threadCount * s_chunksPerThread));
+    if ((threadCount == 1) ||
+        !splitEntries(data, size, chunkSize, chunks) ||
+        (chunks.size() == 1))
+    {
+      Parser parser(data, size);
+      return parser.parse();
+    }
+
+#if defined(PARSER_WITH_STATS)
+    Clock::time_point const chunkStart = Clock::now();
+#endif
+    std::vector<ParsingResult> results(chunks.size());
+    pool.run(chunks.size(), threadCount, [&] (size_t chunk, size_t) {
+      results[chunk] = parseChunk(chunks[chunk], chunk == 0);
+    });
+#if defined(PARSER_WITH_STATS)
+    ParsingStats::Duration const chunkTime =
+      std::chrono::duration_cast<ParsingStats::Duration>(
+        Clock::now() - chunkStart);
+#endif
+
+    bool const success = std::all_of(results.begin(), results.end(),
+      [] (ParsingResult const& result) { return result.m_success; });
+    if (!success) {
+      // Chunk errors have relative positions, so the serial parsing
+      // finds the first error in the document
+      Parser parser(data, size);
+      return parser.parse();
+    }
+
+#if defined(PARSER_WITH_STATS)
+    // With the end of the root section, the counts are the ones
+    // of the serial parsing
+    ParsingStats stats;
+    for (ParsingResult const& result : results) {
+      addStats(stats, result.m_stats);
+    }
+    scaleTimes(stats, chunkTime);
+    char const* const rootEnd = chunks.back().end();
+    addStats(stats,
+      parseRootEnd(TextView(rootEnd, size_t(data + size - rootEnd))));
+    Clock::time_point const mergeStart = Clock::now();
+#endif
+
+    // Pairwise merging keeps the chunk order for any number of threads
+    for (size_t step = 1; step < results.size(); step *= 2) {
+      size_t const pairCount = (results.size() + 2 * step - 1) / (2 * step);
+      pool.run(pairCount, threadCount, [&] (size_t pair, size_t) {
+        size_t const first = 2 * step * pair;
+        if (first + step < results.size()) {
+          mergeTrees(results[first].m_tree, results[first + step].m_tree);
+        }
+      });
+    }
+
+#if defined(PARSER_WITH_STATS)
+    // Merging is building of the tree
+    stats.m_handlingTime +=
+      std::chrono::duration_cast<ParsingStats::Duration>(
+        Clock::now() - mergeStart);
+    results.front().m_stats = stats;
+#endif
+    return std::move(results.front());
+  }
+
+  // Parses a batch document with the parser and the tree builder
+  // of the current thread, so their buffers are reused
+  static ParsingResult parseReusing(TextView input)
+  {
+    static thread_local Parser parser(nullptr, 0);
+    static thread_local TreeBuilder builder;
+
+    parser.reset(input.getData(), input.getSize());
+    builder.reset();
+
+    ParsingResult result = parser.parse(builder);
+    if (result.m_success) {
+      result.m_tree = builder.takeTree();
+    }
+
+    return result;
+  }
+
+  // Parses the entries selected by the projection. The sections on
+  // the paths are scanned for the selected entries like in the index
+  // of LazyDocument, the other values and sections are skipped as
+  // a whole. Selected entries are parsed by the driver started at
+  // the entry. The result has no error details if the input
+  // is malformed.
+  static ParsingResult parseProjected(char const* data, size_t size,
+    Projection const& projection, TreeBuilder& builder)
+  {
+    ParsingResult result;
+    result.m_success = false;
+
+    char const* const end = data + size;
+    char const* current = data;
+    auto skipIgnored = [&] {
+      current = scanning::skipIgnored(current, end);
+      return current != end;
+    };
+
+    constexpr char utf8bom[] = "\xEF\xBB\xBF";
+    if ((3 <= size) && (std::memcmp(data, utf8bom, 3) == 0)) {
+      current += 3;
+    }
+
+    if (!skipIgnored() || (*current != '{')) {
+      return result;
+    }
+    ++current;
+
+    // Projection nodes of the open sections and the category
+    // of the innermost one
+    std::vector<uint32_t> nodes = { Projection::s_root };
+    std::vector<size_t> categoryLengths;
+    Key category;
+    Lexer lexer(nullptr, 0);
+
+    enum class Expected {
+      EntryOrEnd,
+      Entry,
+      SeparatorOrEnd
+    };
+    Expected expected = Expected::EntryOrEnd;
+
+    while (true) {
+      if (!skipIgnored()) {
+        return result;
+      }
+
+      if ((expected != Expected::Entry) && (*current == '}')) {
+        ++current;
+        nodes.pop_back();
+        if (nodes.empty()) {
+#if defined(PARSER_WITH_STATS)
+          result.m_stats.m_bytes = size_t(current - data);
+#endif
+          result.m_success = true;
+          return result;
         }
+        category.resize(categoryLengths.back());
+        categoryLengths.pop_back();
+        expected = Expected::SeparatorOrEnd;
+        continue;
+      }
 
-        // no default for warning
+      if (expected == Expected::SeparatorOrEnd) {
+        if (*current != ',') {
+          return result;
+        }
+        ++current;
+        expected = Expected::Entry;
+        continue;
       }
+
+      char const* const keyBegin = current;
+      current = std::find_if_not(current, end, [] (char c) {
+        return char_classes::is(c, char_classes::KeyChar);
+      });
+      TextView const key(keyBegin, size_t(current - keyBegin));
+      if (key.isEmpty() || !skipIgnored() || (*current != ':')) {
+        return result;
+      }
+      ++current;
+      if (!skipIgnored()) {
+        return result;
+      }
+
+      uint32_t const node = projection.findChild(nodes.back(), key);
+      bool const isOnPath = (node != Projection::s_noNode);
+      bool const isSelected = isOnPath && projection.isSelected(node);
+      bool const isSection = (*current == '{');
+      if (isSection && isOnPath && !isSelected) {
+        if (nodes.size() == s_maxSectionDepth) {
+          return result;
+        }
+        ++current;
+        nodes.push_back(node);
+        categoryLengths.push_back(category.size());
+        if (!category.empty()) {
+          category.push_back(s_categorySeparator);
+        }
+        category.append(key.getData(), key.getSize());
+        expected = Expected::EntryOrEnd;
+        continue;
+      }
+
+      // Values and sections are skipped to their ends, the selected
+      // ones are parsed then
+      if (isSection) {
+        current = scanning::skipSection(current + 1, end);
+      } else if (*current == '"') {
+        char const* const quote = static_cast<char const*>(
+          std::memchr(current + 1, '"', size_t(end - current - 1)));
+        current = quote ? quote : end;
+      } else {
+        return result;
+      }
+      if (current == end) {
+        return result;
+      }
+      ++current;
+
+      if (isSelected) {
+        ParsingResult const status = parseEntry(
+          TextView(keyBegin, size_t(current - keyBegin)), category,
+          nodes.size(), lexer, builder);
+#if defined(PARSER_WITH_STATS)
+        addStats(result.m_stats, status.m_stats);
+#endif
+        if (!status.m_success) {
+          return result;
+        }
+      }
+      expected = Expected::SeparatorOrEnd;
+    }
+  }
+
+  // Parses the selected entry in the section with the category and
+  // the given number of open sections. The entry is valid only if it
+  // is parsed to the end.
+  static ParsingResult parseEntry(TextView entry, Key const& category,
+    size_t depth, Lexer& lexer, TreeBuilder& builder)
+  {
+    lexer.reset(entry.getData(), entry.getSize());
+    builder.enterCategory(category);
+
+    Driver driver({ StateKind::Entry }, depth);
+    ParsingResult result = driver.run(lexer, builder);
+    if (result.m_success &&
+        (lexer.getCurrent().getKind() != TokenKind::ParseEnd))
+    {
+      result.m_success = false;
+    }
+    return result;
+  }
+
+#if defined(PARSER_WITH_STATS)
+  // Sums the statistics of the input parts
+  static void addStats(ParsingStats& stats, ParsingStats const& other)
+  {
+    stats.m_bytes += other.m_bytes;
+    for (size_t kind = 0; kind != stats.m_tokenCounts.size(); ++kind) {
+      stats.m_tokenCounts[kind] += other.m_tokenCounts[kind];
+    }
+    stats.m_maxDepth = std::max(stats.m_maxDepth, other.m_maxDepth);
+    stats.m_lexingTime += other.m_lexingTime;
+    stats.m_parsingTime += other.m_parsingTime;
+    stats.m_handlingTime += other.m_handlingTime;
+    stats.m_totalTime += other.m_totalTime;
+  }
+
+  // Scales the phase times summed over the threads running at once
+  // to the wall-clock time they took
+  static void scaleTimes(ParsingStats& stats,
+    ParsingStats::Duration wallTime)
+  {
+    if (stats.m_totalTime <= wallTime) {
+      return;
     }
 
-    return tree;
+    double const scale =
+      double(wallTime.count()) / double(stats.m_totalTime.count());
+    auto const scaled = [scale] (ParsingStats::Duration time) {
+      return ParsingStats::Duration(
+        ParsingStats::Duration::rep(double(time.count()) * scale));
+    };
+    stats.m_lexingTime = scaled(stats.m_lexingTime);
+    stats.m_handlingTime = scaled(stats.m_handlingTime);
+    stats.m_totalTime = wallTime;
+    stats.m_parsingTime =
+      stats.m_totalTime - stats.m_lexingTime - stats.m_handlingTime;
+  }
+
+  // Sets the total time to the wall-clock time of the whole parsing
+  // call. The time out of lexing and handling is the parsing one.
+  static void setTotalTime(ParsingStats& stats, Clock::time_point start)
+  {
+    stats.m_totalTime =
+      std::chrono::duration_cast<ParsingStats::Duration>(
+        Clock::now() - start);
+    stats.m_parsingTime =
+      stats.m_totalTime - stats.m_lexingTime - stats.m_handlingTime;
   }
+#endif
 };
 
+constexpr Parser::impl::Table Parser::impl::s_table =
+  Parser::impl::makeTable();
+constexpr size_t Parser::impl::s_minChunkSize;
+constexpr size_t Parser::impl::s_chunksPerThread;
+constexpr char Parser::s_categorySeparator;
+constexpr size_t Parser::s_maxSectionDepth;
+
 Parser::Parser(std::istream& is)
   : m_lexer(is)
 {}
 
-Parser::ParsingResult Parser::parse() {
-  // Parses the grammar as LL(1) using predictive LL(1) parser.
+Parser::Parser(char const* data, size_t size)
+  : m_lexer(data, size)
+{}
 
-  using Action = impl::Action;
-  using ActionKind = impl::ActionKind;
-  using StateKind = impl::StateKind;
-  using Product = impl::Product;
+void Parser::reset(char const* data, size_t size)
+{
+  m_lexer.reset(data, size);
+}
 
-  ParsingResult result;
+void Parser::setUtf8Validation(bool enabled)
+{
+  m_lexer.setUtf8Validation(enabled);
+}
 
-  std::stack<StateKind> states;
-  states.push(StateKind::Start);
+Parser::ParsingResult Parser::parse()
+{
+  impl::TreeBuilder builder;
 
-  std::vector<Product> outputSequence;
+  ParsingResult result = parse(builder);
+  if (result.m_success) {
+    result.m_tree = builder.takeTree();
+  }
 
-  auto fail = [&] (Action::Fail const& failure) {
-    result.m_error = impl::makeParsingError(failure);
-  };
+  return result;
+}
 
-  auto expect = [&] (Action::Expect const& expectation) {
-    std::for_each(
-      expectation.m_expectedProductions.rbegin(),
-      expectation.m_expectedProductions.rend(),
-      [&] (auto const& entry) {
-        states.push(entry);
-      });
-  };
+Parser::InternedParsingResult Parser::parse(KeyPool& keys)
+{
+  impl::BasicTreeBuilder<InternedTree> builder{ InternedTree(), &keys };
 
-  auto accept = [&] (Action::Produce const& production) {
-    for (auto const& entry : production.m_producedSymbols) {
-      outputSequence.push_back(entry);
-    }
-  };
+  ParsingResult status = parse(builder);
 
-  auto doAction = [&] (Action const& action) -> bool {
-    switch (action.m_kind) {
-      case ActionKind::Expect:
-        expect(action.m_expectation);
-        return true;
+  InternedParsingResult result;
+  result.m_success = status.m_success;
+  result.m_error = status.m_error;
+  if (result.m_success) {
+    result.m_tree = builder.takeTree();
+  }
+#if defined(PARSER_WITH_STATS)
+  result.m_stats = status.m_stats;
+#endif
 
-      case ActionKind::Produce:
-        accept(action.m_production);
-        return true;
+  return result;
+}
 
-      case ActionKind::Fail:
-        fail(action.m_failure);
-        return false;
+#if defined(PARSER_WITH_PMR)
+Parser::PmrParsingResult Parser::parse(std::pmr::memory_resource* resource)
+{
+  impl::BasicTreeBuilder<PmrParsedTree> builder{ PmrParsedTree(resource) };
 
-      // no default for warning
-    }
-    return false;
-  };
+  ParsingResult status = parse(builder);
 
-  result.m_success = true;
-  while (result.m_success && !states.empty()) {
-    auto state = states.top();
-    states.pop();
-    auto action = impl::doTransition(state, m_lexer);
-    result.m_success = doAction(action);
+  PmrParsingResult result(resource);
+  result.m_success = status.m_success;
+  result.m_error = status.m_error;
+  if (result.m_success) {
+    result.m_tree = builder.takeTree();
   }
+#if defined(PARSER_WITH_STATS)
+  result.m_stats = status.m_stats;
+#endif
 
+  return result;
+}
+#endif // PARSER_WITH_PMR
+
+Parser::ParsingResult Parser::parse(ParsingHandler& handler)
+{
+  impl::Driver driver;
+  return driver.run(m_lexer, handler);
+}
+
+Parser::ParsingResult Parser::parseProjection(char const* data, size_t size,
+  Projection const& projection)
+{
+  if (projection.isSelected(Projection::s_root)) {
+    Parser parser(data, size);
+    return parser.parse();
+  }
+
+#if defined(PARSER_WITH_STATS)
+  impl::Clock::time_point const start = impl::Clock::now();
+#endif
+  impl::TreeBuilder builder;
+  ParsingResult result =
+    impl::parseProjected(data, size, projection, builder);
   if (result.m_success) {
-    result.m_tree = impl::makeOutputTree(outputSequence);
+    result.m_tree = builder.takeTree();
+#if defined(PARSER_WITH_STATS)
+    impl::setTotalTime(result.m_stats, start);
+#endif
+    return result;
   }
 
+  // The scanning keeps no error details, so the input is parsed again
+  // to find the error position. The input may be valid if the scanning
+  // is stricter than the parser, then the tree is projected.
+  Parser parser(data, size);
+  result = parser.parse();
+  for (auto iEntry = result.m_tree.begin(); iEntry != result.m_tree.end(); ) {
+    if (projection.selects(iEntry->first)) {
+      ++iEntry;
+    } else {
+      iEntry = result.m_tree.erase(iEntry);
+    }
+  }
+#if defined(PARSER_WITH_STATS)
+  impl::setTotalTime(result.m_stats, start);
+#endif
+  return result;
+}
+
+Parser::ParsingResult Parser::parseFile(std::string const& path)
+{
+  MappedFile file;
+  if (!file.open(path)) {
+    ParsingResult result;
+    result.m_success = false;
+    result.m_error.m_kind = ParsingErrorKind::InputReadError;
+    result.m_error.m_position = 0;
+    result.m_error.m_line = 0;
+    result.m_error.m_column = 0;
+    return result;
+  }
+
+  Parser parser(file.getData(), file.getSize());
+  return parser.parse();
+}
+
+Parser::ParsingResult Parser::parseParallel(char const* data, size_t size,
+  size_t threadCount)
+{
+#if defined(PARSER_WITH_STATS)
+  impl::Clock::time_point const start = impl::Clock::now();
+  ParsingResult result = impl::parseParallel(data, size, threadCount);
+  impl::setTotalTime(result.m_stats, start);
   return result;
+#else
+  return impl::parseParallel(data, size, threadCount);
+#endif
+}
+
+std::vector<Parser::ParsingResult> Parser::parseBatch(TextView const* inputs,
+  size_t count, size_t threadCount)
+{
+  ThreadPool& pool = ThreadPool::getShared();
+  if (threadCount == 0) {
+    threadCount = pool.getWorkerCount() + 1;
+  }
+
+  std::vector<ParsingResult> results(count);
+  pool.run(count, threadCount, [&] (size_t input, size_t) {
+    results[input] = impl::parseReusing(inputs[input]);
+  });
+
+  return results;
+}
+
+
+class PushParser::impl {
+public:
+  explicit impl(ParsingHandler* handler)
+    : m_builder()
+    , m_handler(handler ? handler : &m_builder)
+    , m_lexer(nullptr, 0)
+    , m_driver()
+    , m_result()
+    , m_pending()
+    , m_offset(0)
+    , m_isInValue(false)
+  {
+    reset();
+  }
+
+  bool feed(char const* data, size_t size)
+  {
+    if (!m_result.m_success || m_driver.isFinished()) {
+      return m_result.m_success;
+    }
+
+    // The pending bytes are scanned already and have no token end
+    char const* window = data;
+    size_t windowSize = size;
+    size_t scanned = 0;
+    if (!m_pending.empty()) {
+      scanned = m_pending.size();
+      m_pending.append(data, size);
+      window = m_pending.data();
+      windowSize = m_pending.size();
+    }
+
+    size_t const complete = findCompleteTokens(window, windowSize, scanned);
+    if (complete != 0) {
+      parse(window, complete);
+    }
+
+    if (window == data) {
+      m_pending.assign(data + complete, size - complete);
+    } else {
+      m_pending.erase(0, complete);
+    }
+    m_offset += complete;
+
+    return m_result.m_success;
+  }
+
+  bool isComplete() const
+  {
+    return m_result.m_success && m_driver.isFinished();
+  }
+
+  Parser::ParsingResult finish()
+  {
+    if (m_result.m_success && !m_driver.isFinished()) {
+      m_driver.setPartialInput(false);
+      parse(m_pending.data(), m_pending.size());
+    }
+
+    Parser::ParsingResult result = std::move(m_result);
+    if (result.m_success && (m_handler == &m_builder)) {
+      result.m_tree = m_builder.takeTree();
+    }
+
+    reset();
+    return result;
+  }
+
+private:
+  // Returns the length of the data prefix ending with the last complete
+  // token, which can be lexed without the next bytes. Section braces,
+  // entry separators and value ends complete the previous tokens
+  // as well. The value state is updated for the bytes after the scanned
+  // ones.
+  size_t findCompleteTokens(char const* data, size_t size, size_t scanned)
+  {
+    char const* const end = data + size;
+    char const* current = data + scanned;
+    char const* complete = data;
+
+    while (current != end) {
+      if (m_isInValue) {
+        // There is no escape sequence for a quote
+        current = static_cast<char const*>(
+          std::memchr(current, '"', size_t(end - current)));
+        if (!current) {
+          break;
+        }
+        m_isInValue = false;
+        complete = ++current;
+        continue;
+      }
+
+      current = scanning::findStructural(current, end);
+      if (current == end) {
+        break;
+      }
+      if (*current == '"') {
+        m_isInValue = true;
+        ++current;
+      } else {
+        complete = ++current;
+      }
+    }
+
+    return size_t(complete - data);
+  }
+
+  void parse(char const* data, size_t size)
+  {
+    m_lexer.reset(data, size, m_offset);
+    Parser::ParsingResult result = m_driver.run(m_lexer, *m_handler);
+#if defined(PARSER_WITH_STATS)
+    m_result.m_stats = result.m_stats;
+#endif
+    if (!result.m_success) {
+      m_result = std::move(result);
+    }
+  }
+
+  void reset()
+  {
+    m_builder.reset();
+    m_driver = Parser::impl::Driver();
+    m_driver.setPartialInput(true);
+    m_result = Parser::ParsingResult();
+    m_result.m_success = true;
+    m_pending.clear();
+    m_offset = 0;
+    m_isInValue = false;
+  }
+
+  Parser::impl::TreeBuilder m_builder;
+  ParsingHandler* m_handler;
+
+  Lexer m_lexer;
+  Parser::impl::Driver m_driver;
+  Parser::ParsingResult m_result;
+
+  std::string m_pending; // bytes of incomplete tokens
+  size_t m_offset; // position of the pending bytes in the input
+  bool m_isInValue; // if the pending bytes end inside of a value
+};
+
+PushParser::PushParser()
+  : m_impl(new impl(nullptr))
+{}
+
+PushParser::PushParser(ParsingHandler& handler)
+  : m_impl(new impl(&handler))
+{}
+
+PushParser::~PushParser() = default;
+
+bool PushParser::feed(char const* data, size_t size)
+{
+  return m_impl->feed(data, size);
+}
+
+bool PushParser::isComplete() const
+{
+  return m_impl->isComplete();
+}
+
+Parser::ParsingResult PushParser::finish()
+{
+  return m_impl->finish();
 }
 
 } // namespace parsing
@@ -0,0 +1,111 @@
+#include "projection.hxx"
+
+#include <algorithm>
+
+
+namespace parsing {
+
+constexpr uint32_t Projection::s_noNode;
+constexpr uint32_t Projection::s_root;
+
+Projection::Projection()
+  : m_nodes(1, Node{ {}, false })
+  , m_pathCount(0)
+{}
+
+Projection::Projection(std::initializer_list<TextView> paths)
+  : Projection()
+{
+  for (TextView path : paths) {
+    add(path);
+  }
+}
+
+Projection::Projection(std::vector<std::string> const& paths)
+  : Projection()
+{
+  for (std::string const& path : paths) {
+    add(path);
+  }
+}
+
+void Projection::add(TextView path)
+{
+  ++m_pathCount;
+
+  uint32_t node = s_root;
+  char const* key = path.begin();
+  while (!path.isEmpty()) {
+    char const* const keyEnd =
+      std::find(key, path.end(), Parser::s_categorySeparator);
+    TextView const name(key, size_t(keyEnd - key));
+
+    std::vector<Child>& children = m_nodes[node].m_children;
+    auto const iChild = std::lower_bound(children.begin(), children.end(),
+      name, [] (Child const& child, TextView text) {
+        return TextView(child.m_key) < text;
+      });
+    if ((iChild != children.end()) && (iChild->m_key == name)) {
+      node = iChild->m_node;
+    } else {
+      uint32_t const child = uint32_t(m_nodes.size());
+      children.insert(iChild, Child{ name.toString(), child });
+      m_nodes.push_back(Node{ {}, false });
+      node = child;
+    }
+
+    if (keyEnd == path.end()) {
+      break;
+    }
+    key = keyEnd + 1;
+  }
+
+  m_nodes[node].m_isSelected = true;
+}
+
+size_t Projection::getPathCount() const
+{
+  return m_pathCount;
+}
+
+bool Projection::selects(TextView key) const
+{
+  uint32_t node = s_root;
+  char const* name = key.begin();
+  while (!isSelected(node)) {
+    if (key.isEmpty()) {
+      return false;
+    }
+    char const* const nameEnd =
+      std::find(name, key.end(), Parser::s_categorySeparator);
+    node = findChild(node, TextView(name, size_t(nameEnd - name)));
+    if (node == s_noNode) {
+      return false;
+    }
+    if (nameEnd == key.end()) {
+      return isSelected(node);
+    }
+    name = nameEnd + 1;
+  }
+  return true;
+}
+
+uint32_t Projection::findChild(uint32_t node, TextView key) const
+{
+  std::vector<Child> const& children = m_nodes[node].m_children;
+  auto const iChild = std::lower_bound(children.begin(), children.end(),
+    key, [] (Child const& child, TextView text) {
+      return TextView(child.m_key) < text;
+    });
+  if ((iChild == children.end()) || !(iChild->m_key == key)) {
+    return s_noNode;
+  }
+  return iChild->m_node;
+}
+
+bool Projection::isSelected(uint32_t node) const
+{
+  return m_nodes[node].m_isSelected;
+}
+
+} // namespace parsing
@@ -0,0 +1,864 @@
+#include "scanning.hxx"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if PARSING_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if PARSING_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+
+namespace parsing {
+namespace scanning {
+
+namespace {
+
+bool isAscii(char c)
+{
+  return static_cast<unsigned char>(c) < 0x80;
+}
+
+bool isContinuation(char c)
+{
+  return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Returns the end of the multibyte sequence starting at the byte,
+// or null if the sequence is invalid
+char const* skipSequence(char const* begin, char const* end)
+{
+  // Well-formed sequences, Unicode Standard, table 3-7. The second byte
+  // range excludes overlong forms, surrogates and too large code points.
+  unsigned char const lead = static_cast<unsigned char>(*begin);
+  ptrdiff_t length = 0;
+  unsigned char low = 0x80;
+  unsigned char high = 0xBF;
+  if ((0xC2 <= lead) && (lead <= 0xDF)) {
+    length = 2;
+  } else if (lead == 0xE0) {
+    length = 3;
+    low = 0xA0;
+  } else if (lead == 0xED) {
+    length = 3;
+    high = 0x9F;
+  } else if ((0xE1 <= lead) && (lead <= 0xEF)) {
+    length = 3;
+  } else if (lead == 0xF0) {
+    length = 4;
+    low = 0x90;
+  } else if ((0xF1 <= lead) && (lead <= 0xF3)) {
+    length = 4;
+  } else if (lead == 0xF4) {
+    length = 4;
+    high = 0x8F;
+  } else {
+    return nullptr;
+  }
+
+  if (end - begin < length) {
+    return nullptr;
+  }
+
+  unsigned char const second = static_cast<unsigned char>(begin[1]);
+  if ((second < low) || (high < second)) {
+    return nullptr;
+  }
+  for (ptrdiff_t i = 2; i != length; ++i) {
+    if (!isContinuation(begin[i])) {
+      return nullptr;
+    }
+  }
+  return begin + length;
+}
+
+// Skips the multibyte sequences from the begin. Returns the first
+// ASCII byte, or null with the begin at the invalid sequence.
+char const* skipMultibyte(char const*& begin, char const* end)
+{
+  while ((begin != end) && !isAscii(*begin)) {
+    char const* const next = skipSequence(begin, end);
+    if (!next) {
+      return nullptr;
+    }
+    begin = next;
+  }
+  return begin;
+}
+
+// Reads the code point of 4 hex digits. Returns -1 if there is
+// a wrong digit.
+int32_t readHexCodepoint(char const* text)
+{
+  // The first digit is the highest byte
+  uint32_t const bytes = (uint32_t(uint8_t(text[0])) << 24)
+    | (uint32_t(uint8_t(text[1])) << 16)
+    | (uint32_t(uint8_t(text[2])) << 8)
+    | uint32_t(uint8_t(text[3]));
+
+  // Bytes are compared with the range bounds in parallel. Adding
+  // 0x80 - low sets the high bit of ASCII bytes not less than low,
+  // adding 0x7F - high sets it for the ones greater than high.
+  // Non-ASCII bytes are wrong, so their carries do not matter.
+  constexpr uint32_t highBits = 0x80808080;
+  uint32_t const lower = bytes | 0x20202020;
+  uint32_t const digits = (bytes + 0x50505050) & ~(bytes + 0x46464646);
+  uint32_t const letters = (lower + 0x1F1F1F1F) & ~(lower + 0x19191919);
+  if (((digits | letters) & ~bytes & highBits) != highBits) {
+    return -1;
+  }
+
+  // Letters have low nibbles of 1-6 for the digits of 10-15
+  uint32_t const nibbles =
+    (bytes & 0x0F0F0F0F) + ((letters & highBits) >> 7) * 9;
+  uint32_t const pairs = nibbles | (nibbles >> 4);
+  return int32_t(((pairs >> 8) & 0xFF00) | (pairs & 0xFF));
+}
+
+// Writes the code point as UTF-8. Returns the output end.
+char* writeUtf8(char* output, uint32_t codepoint)
+{
+  if (codepoint < 0x80) {
+    output[0] = char(codepoint);
+    return output + 1;
+  } else if (codepoint < 0x800) {
+    output[0] = char(0xC0 | (codepoint >> 6));
+    output[1] = char(0x80 | (codepoint & 0x3F));
+    return output + 2;
+  } else if (codepoint < 0x10000) {
+    output[0] = char(0xE0 | (codepoint >> 12));
+    output[1] = char(0x80 | ((codepoint >> 6) & 0x3F));
+    output[2] = char(0x80 | (codepoint & 0x3F));
+    return output + 3;
+  }
+  output[0] = char(0xF0 | (codepoint >> 18));
+  output[1] = char(0x80 | ((codepoint >> 12) & 0x3F));
+  output[2] = char(0x80 | ((codepoint >> 6) & 0x3F));
+  output[3] = char(0x80 | (codepoint & 0x3F));
+  return output + 4;
+}
+
+// Progress of skipping a section: the number of open sections
+// and whether the last byte is in a value
+struct SectionState {
+  size_t m_depth;
+  bool m_isInValue;
+};
+
+// Returns the brace closing the section, or end if there is none
+char const* skipSectionBytes(char const* begin, char const* end,
+  SectionState& state)
+{
+  for (; begin != end; ++begin) {
+    if (*begin == '"') {
+      state.m_isInValue = !state.m_isInValue;
+    } else if (state.m_isInValue) {
+      continue;
+    } else if (*begin == '{') {
+      ++state.m_depth;
+    } else if ((*begin == '}') && (--state.m_depth == 0)) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+} // namespace
+
+namespace scalar {
+
+char const* skipIgnored(char const* begin, char const* end)
+{
+  while ((begin != end) && isIgnored(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+char const* findValueSpecial(char const* begin, char const* end)
+{
+  while ((begin != end) && !isValueSpecial(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+char const* findStructural(char const* begin, char const* end)
+{
+  while ((begin != end) && !isStructural(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+char const* findInvalidUtf8(char const* begin, char const* end)
+{
+  while (begin != end) {
+    if (isAscii(*begin)) {
+      ++begin;
+    } else if (!skipMultibyte(begin, end)) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+char const* skipSection(char const* begin, char const* end)
+{
+  SectionState state = { 1, false };
+  return skipSectionBytes(begin, end, state);
+}
+
+} // namespace scalar
+
+
+namespace {
+
+inline int countTrailingZeros(unsigned int mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int count = 0;
+  while ((mask & 1) == 0) {
+    mask >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+inline int countOnes(uint32_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcount(mask);
+#else
+  int count = 0;
+  for (; mask != 0; mask &= mask - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+// Finds the brace closing the section in the block of up to 32 bytes
+// with the masks of quotes and braces. Returns the brace index, or -1
+// with the state updated for the next block.
+inline int findSectionEnd(uint32_t quotes, uint32_t opens, uint32_t closes,
+  SectionState& state)
+{
+  // Prefix XOR marks the bytes from an opening quote to the closing one.
+  // The bits past the block keep the state of its last byte.
+  uint32_t values = quotes;
+  values ^= values << 1;
+  values ^= values << 2;
+  values ^= values << 4;
+  values ^= values << 8;
+  values ^= values << 16;
+  if (state.m_isInValue) {
+    values = ~values;
+  }
+  state.m_isInValue = (values >> 31) != 0;
+  opens &= ~values;
+  closes &= ~values;
+
+  // The section can only end in the block with enough closing braces
+  size_t const closeCount = size_t(countOnes(closes));
+  if (closeCount < state.m_depth) {
+    state.m_depth += size_t(countOnes(opens)) - closeCount;
+    return -1;
+  }
+  for (uint32_t braces = opens | closes; braces != 0;
+      braces &= braces - 1)
+  {
+    int const index = countTrailingZeros(braces);
+    if ((opens >> index) & 1) {
+      ++state.m_depth;
+    } else if (--state.m_depth == 0) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+} // namespace
+
+
+#if PARSING_HAS_SSE2
+namespace sse2 {
+
+namespace {
+
+constexpr int s_width = 16;
+
+// Marks bytes in the [0x00; 0x20] range and 0x7F
+inline __m128i markIgnored(__m128i bytes)
+{
+  __m128i const space = _mm_set1_epi8(0x20);
+  __m128i const del = _mm_set1_epi8(0x7F);
+  __m128i const lowest = _mm_cmpeq_epi8(_mm_min_epu8(bytes, space), bytes);
+  return _mm_or_si128(lowest, _mm_cmpeq_epi8(bytes, del));
+}
+
+// Marks bytes in the [0x00; 0x1F] range, 0x7F, '"' and '\'
+inline __m128i markValueSpecial(__m128i bytes)
+{
+  __m128i const control = _mm_set1_epi8(0x1F);
+  __m128i const del = _mm_set1_epi8(0x7F);
+  __m128i const quote = _mm_set1_epi8('"');
+  __m128i const escape = _mm_set1_epi8('\\');
+  __m128i const lowest = _mm_cmpeq_epi8(_mm_min_epu8(bytes, control), bytes);
+  return _mm_or_si128(
+    _mm_or_si128(lowest, _mm_cmpeq_epi8(bytes, del)),
+    _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+      _mm_cmpeq_epi8(bytes, escape)));
+}
+
+// Marks '"', '{', '}' and ','
+inline __m128i markStructural(__m128i bytes)
+{
+  return _mm_or_si128(
+    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')),
+      _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))),
+    _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('{')),
+      _mm_cmpeq_epi8(bytes, _mm_set1_epi8('}'))));
+}
+
+} // namespace
+
+char const* skipIgnored(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m128i const bytes =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin));
+    unsigned int const mask =
+      ~static_cast<unsigned int>(_mm_movemask_epi8(markIgnored(bytes)))
+      & 0xFFFF;
+    if (mask != 0) {
+      return begin + countTrailingZeros(mask);
+    }
+    begin += s_width;
+  }
+  return scalar::skipIgnored(begin, end);
+}
+
+char const* findValueSpecial(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m128i const bytes =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin));
+    unsigned int const mask =
+      static_cast<unsigned int>(_mm_movemask_epi8(markValueSpecial(bytes)));
+    if (mask != 0) {
+      return begin + countTrailingZeros(mask);
+    }
+    begin += s_width;
+  }
+  return scalar::findValueSpecial(begin, end);
+}
+
+char const* findStructural(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m128i const bytes =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin));
+    unsigned int const mask =
+      static_cast<unsigned int>(_mm_movemask_epi8(markStructural(bytes)));
+    if (mask != 0) {
+      return begin + countTrailingZeros(mask);
+    }
+    begin += s_width;
+  }
+  return scalar::findStructural(begin, end);
+}
+
+char const* findInvalidUtf8(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m128i const bytes =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin));
+    unsigned int const mask =
+      static_cast<unsigned int>(_mm_movemask_epi8(bytes));
+    if (mask == 0) {
+      begin += s_width;
+      continue;
+    }
+    begin += countTrailingZeros(mask);
+    if (!skipMultibyte(begin, end)) {
+      return begin;
+    }
+  }
+  return scalar::findInvalidUtf8(begin, end);
+}
+
+char const* skipSection(char const* begin, char const* end)
+{
+  SectionState state = { 1, false };
+  while (s_width <= end - begin) {
+    __m128i const bytes =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin));
+    uint32_t const quotes = uint32_t(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'))));
+    uint32_t const opens = uint32_t(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('{'))));
+    uint32_t const closes = uint32_t(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('}'))));
+    int const index = findSectionEnd(quotes, opens, closes, state);
+    if (index >= 0) {
+      return begin + index;
+    }
+    begin += s_width;
+  }
+  return skipSectionBytes(begin, end, state);
+}
+
+} // namespace sse2
+#endif // PARSING_HAS_SSE2
+
+
+#if PARSING_HAS_AVX2
+namespace avx2 {
+
+namespace {
+
+constexpr int s_width = 32;
+
+__attribute__((target("avx2")))
+inline __m256i markIgnored(__m256i bytes)
+{
+  __m256i const space = _mm256_set1_epi8(0x20);
+  __m256i const del = _mm256_set1_epi8(0x7F);
+  __m256i const lowest =
+    _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, space), bytes);
+  return _mm256_or_si256(lowest, _mm256_cmpeq_epi8(bytes, del));
+}
+
+__attribute__((target("avx2")))
+inline __m256i markValueSpecial(__m256i bytes)
+{
+  __m256i const control = _mm256_set1_epi8(0x1F);
+  __m256i const del = _mm256_set1_epi8(0x7F);
+  __m256i const quote = _mm256_set1_epi8('"');
+  __m256i const escape = _mm256_set1_epi8('\\');
+  __m256i const lowest =
+    _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, control), bytes);
+  return _mm256_or_si256(
+    _mm256_or_si256(lowest, _mm256_cmpeq_epi8(bytes, del)),
+    _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote),
+      _mm256_cmpeq_epi8(bytes, escape)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i markStructural(__m256i bytes)
+{
+  return _mm256_or_si256(
+    _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')),
+      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))),
+    _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('{')),
+      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('}'))));
+}
+
+
+// Error bits of byte pairs for the UTF-8 validation by lookups
+// of the byte nibbles, by J. Keiser and D. Lemire
+enum Utf8Error : uint8_t {
+  TooShort = 1 << 0, // lead followed by a lead or ASCII
+  TooLong = 1 << 1, // ASCII followed by a continuation
+  Overlong3 = 1 << 2, // 11100000 100_____
+  TooLarge = 1 << 3, // 11110100 1001____, 11110100 101_____, 11110101+
+  Surrogate = 1 << 4, // 11101101 101_____
+  Overlong2 = 1 << 5, // 1100000_ 10______
+  TooLarge1000 = 1 << 6, // 11110101+ 1000____
+  Overlong4 = 1 << 6, // 11110000 1000____
+  TwoContinuations = 1 << 7, // 10______ 10______, valid in long sequences
+  Carry = TooShort | TooLong | TwoContinuations
+};
+
+// Bytes of the previous block and the current one, shifted by the count
+template <int Count>
+__attribute__((target("avx2")))
+inline __m256i getPrevious(__m256i bytes, __m256i previous)
+{
+  return _mm256_alignr_epi8(bytes,
+    _mm256_permute2x128_si256(previous, bytes, 0x21), 16 - Count);
+}
+
+__attribute__((target("avx2")))
+inline __m256i getHighNibbles(__m256i bytes)
+{
+  return _mm256_and_si256(_mm256_srli_epi16(bytes, 4),
+    _mm256_set1_epi8(0x0F));
+}
+
+// Table for both 128-bit lanes
+__attribute__((target("avx2")))
+inline __m256i makeLookup(
+  uint8_t v0, uint8_t v1, uint8_t v2, uint8_t v3,
+  uint8_t v4, uint8_t v5, uint8_t v6, uint8_t v7,
+  uint8_t v8, uint8_t v9, uint8_t v10, uint8_t v11,
+  uint8_t v12, uint8_t v13, uint8_t v14, uint8_t v15)
+{
+  return _mm256_setr_epi8(
+    char(v0), char(v1), char(v2), char(v3),
+    char(v4), char(v5), char(v6), char(v7),
+    char(v8), char(v9), char(v10), char(v11),
+    char(v12), char(v13), char(v14), char(v15),
+    char(v0), char(v1), char(v2), char(v3),
+    char(v4), char(v5), char(v6), char(v7),
+    char(v8), char(v9), char(v10), char(v11),
+    char(v12), char(v13), char(v14), char(v15));
+}
+
+// Marks errors of the sequences ending in the block. Sequences
+// started in the previous block are checked as well.
+__attribute__((target("avx2")))
+inline __m256i markUtf8Errors(__m256i bytes, __m256i previous)
+{
+  __m256i const previous1 = getPrevious<1>(bytes, previous);
+
+  __m256i const byte1High = _mm256_shuffle_epi8(makeLookup(
+    // 0_______ ________
+    TooLong, TooLong, TooLong, TooLong,
+    TooLong, TooLong, TooLong, TooLong,
+    // 10______ ________
+    TwoContinuations, TwoContinuations, TwoContinuations, TwoContinuations,
+    // 1100____ ________
+    TooShort | Overlong2,
+    // 1101____ ________
+    TooShort,
+    // 1110____ ________
+    TooShort | Overlong3 | Surrogate,
+    // 1111____ ________
+    TooShort | TooLarge | TooLarge1000 | Overlong4),
+    getHighNibbles(previous1));
+
+  uint8_t const large = Carry | TooLarge | TooLarge1000;
+  __m256i const byte1Low = _mm256_shuffle_epi8(makeLookup(
+    // ____0000 ________
+    Carry | Overlong3 | Overlong2 | Overlong4,
+    // ____0001 ________
+    Carry | Overlong2,
+    // ____001_ ________
+    Carry, Carry,
+    // ____0100 ________
+    Carry | TooLarge,
+    // ____0101 ________ and above
+    large, large, large, large, large, large, large, large,
+    // ____1101 ________
+    large | Surrogate,
+    large, large),
+    _mm256_and_si256(previous1, _mm256_set1_epi8(0x0F)));
+
+  uint8_t const continuation = TooLong | Overlong2 | TwoContinuations;
+  __m256i const byte2High = _mm256_shuffle_epi8(makeLookup(
+    // ________ 0_______
+    TooShort, TooShort, TooShort, TooShort,
+    TooShort, TooShort, TooShort, TooShort,
+    // ________ 1000____
+    continuation | Overlong3 | TooLarge1000 | Overlong4,
+    // ________ 1001____
+    continuation | Overlong3 | TooLarge,
+    // ________ 101_____
+    continuation | Surrogate | TooLarge,
+    continuation | Surrogate | TooLarge,
+    // ________ 11______
+    TooShort, TooShort, TooShort, TooShort),
+    getHighNibbles(bytes));
+
+  __m256i const special =
+    _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+  // Two continuations are valid only in the third and fourth bytes
+  // of the 3 and 4-byte sequences
+  __m256i const isThirdByte = _mm256_subs_epu8(
+    getPrevious<2>(bytes, previous), _mm256_set1_epi8(char(0xE0 - 0x80)));
+  __m256i const isFourthByte = _mm256_subs_epu8(
+    getPrevious<3>(bytes, previous), _mm256_set1_epi8(char(0xF0 - 0x80)));
+  __m256i const mustBeContinuation = _mm256_and_si256(
+    _mm256_or_si256(isThirdByte, isFourthByte),
+    _mm256_set1_epi8(char(0x80)));
+
+  return _mm256_xor_si256(mustBeContinuation, special);
+}
+
+// Marks the leads in the block end, which need more bytes
+__attribute__((target("avx2")))
+inline __m256i markIncompleteUtf8(__m256i bytes)
+{
+  __m256i const maxValues = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+  return _mm256_subs_epu8(bytes, maxValues);
+}
+
+// Returns the begin of the sequence with the byte, assuming
+// the text before it is valid
+inline char const* findSequenceBegin(char const* first, char const* position)
+{
+  char const* lead = position;
+  for (int i = 0; (i != 3) && (lead != first) && isContinuation(*lead); ++i)
+  {
+    --lead;
+  }
+  return ((lead == first) || !isContinuation(*lead)) ? lead : position;
+}
+
+} // namespace
+
+__attribute__((target("avx2")))
+char const* skipIgnored(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m256i const bytes =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin));
+    unsigned int const mask =
+      ~static_cast<unsigned int>(_mm256_movemask_epi8(markIgnored(bytes)));
+    if (mask != 0) {
+      return begin + countTrailingZeros(mask);
+    }
+    begin += s_width;
+  }
+  return sse2::skipIgnored(begin, end);
+}
+
+__attribute__((target("avx2")))
+char const* findValueSpecial(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m256i const bytes =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin));
+    unsigned int const mask = static_cast<unsigned int>(
+      _mm256_movemask_epi8(markValueSpecial(bytes)));
+    if (mask != 0) {
+      return begin + countTrailingZeros(mask);
+    }
+    begin += s_width;
+  }
+  return sse2::findValueSpecial(begin, end);
+}
+
+__attribute__((target("avx2")))
+char const* findStructural(char const* begin, char const* end)
+{
+  while (s_width <= end - begin) {
+    __m256i const bytes =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin));
+    unsigned int const mask = static_cast<unsigned int>(
+      _mm256_movemask_epi8(markStructural(bytes)));
+    if (mask != 0) {
+      return begin + countTrailingZeros(mask);
+    }
+    begin += s_width;
+  }
+  return sse2::findStructural(begin, end);
+}
+
+__attribute__((target("avx2")))
+char const* findInvalidUtf8(char const* begin, char const* end)
+{
+  char const* const first = begin;
+  __m256i previous = _mm256_setzero_si256();
+  __m256i incomplete = _mm256_setzero_si256();
+
+  while (true) {
+    // The tail is padded with zeros, which are ASCII, so the sequences
+    // incomplete at the end are found as the other errors
+    ptrdiff_t const size = std::min<ptrdiff_t>(s_width, end - begin);
+    __m256i bytes = _mm256_setzero_si256();
+    if (size == s_width) {
+      bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin));
+    } else if (size != 0) {
+      alignas(s_width) char tail[s_width] = {};
+      std::memcpy(tail, begin, size_t(size));
+      bytes = _mm256_load_si256(reinterpret_cast<__m256i const*>(tail));
+    }
+
+    // Sequences continued in the block are checked with the previous
+    // bytes, ASCII blocks only need to follow complete sequences
+    __m256i errors = incomplete;
+    if (_mm256_movemask_epi8(bytes) == 0) {
+      incomplete = _mm256_setzero_si256();
+    } else {
+      errors = markUtf8Errors(bytes, previous);
+      incomplete = markIncompleteUtf8(bytes);
+    }
+
+    if (!_mm256_testz_si256(errors, errors)) {
+      break;
+    }
+    if (size != s_width) {
+      return end;
+    }
+    previous = bytes;
+    begin += s_width;
+  }
+
+  // The error position is found by the scalar code, starting from
+  // the previous block, which may have an incomplete sequence
+  char const* const blockBegin =
+    (begin - first < s_width) ? first : begin - s_width;
+  return scalar::findInvalidUtf8(findSequenceBegin(first, blockBegin), end);
+}
+
+__attribute__((target("avx2")))
+char const* skipSection(char const* begin, char const* end)
+{
+  SectionState state = { 1, false };
+  while (s_width <= end - begin) {
+    __m256i const bytes =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin));
+    uint32_t const quotes = uint32_t(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'))));
+    uint32_t const opens = uint32_t(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('{'))));
+    uint32_t const closes = uint32_t(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('}'))));
+    int const index = findSectionEnd(quotes, opens, closes, state);
+    if (index >= 0) {
+      return begin + index;
+    }
+    begin += s_width;
+  }
+  return skipSectionBytes(begin, end, state);
+}
+
+} // namespace avx2
+#endif // PARSING_HAS_AVX2
+
+
+bool isAvx2Supported()
+{
+#if PARSING_HAS_AVX2
+  static bool const supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+namespace {
+
+struct Kernels {
+  using Function = char const* (*)(char const*, char const*);
+
+  Function m_skipIgnored;
+  Function m_findValueSpecial;
+  Function m_findStructural;
+  Function m_findInvalidUtf8;
+  Function m_skipSection;
+};
+
+Kernels selectKernels()
+{
+#if PARSING_HAS_AVX2
+  if (isAvx2Supported()) {
+    return { avx2::skipIgnored, avx2::findValueSpecial,
+      avx2::findStructural, avx2::findInvalidUtf8, avx2::skipSection };
+  }
+#endif
+#if PARSING_HAS_SSE2
+  return { sse2::skipIgnored, sse2::findValueSpecial,
+    sse2::findStructural, sse2::findInvalidUtf8, sse2::skipSection };
+#else
+  return { scalar::skipIgnored, scalar::findValueSpecial,
+    scalar::findStructural, scalar::findInvalidUtf8, scalar::skipSection };
+#endif
+}
+
+Kernels const& getKernels()
+{
+  static Kernels const kernels = selectKernels();
+  return kernels;
+}
+
+} // namespace
+
+char const* skipIgnored(char const* begin, char const* end)
+{
+  return getKernels().m_skipIgnored(begin, end);
+}
+
+char const* findValueSpecial(char const* begin, char const* end)
+{
+  return getKernels().m_findValueSpecial(begin, end);
+}
+
+char const* findStructural(char const* begin, char const* end)
+{
+  return getKernels().m_findStructural(begin, end);
+}
+
+char const* findInvalidUtf8(char const* begin, char const* end)
+{
+  return getKernels().m_findInvalidUtf8(begin, end);
+}
+
+char const* skipSection(char const* begin, char const* end)
+{
+  return getKernels().m_skipSection(begin, end);
+}
+
+DecodedEscapes decodeEscapes(char const* begin, char const* end,
+  char* output)
+{
+  // Sizes of sequences like '\n' and like '\x0041'
+  constexpr ptrdiff_t shortSize = 2;
+  constexpr ptrdiff_t codepointSize = 6;
+
+  while ((shortSize <= end - begin) && (begin[0] == '\\')) {
+    switch (begin[1]) {
+      case 'n':
+        *output++ = '\n';
+        begin += shortSize;
+        continue;
+      case 'r':
+        *output++ = '\r';
+        begin += shortSize;
+        continue;
+      case '\\':
+        *output++ = '\\';
+        begin += shortSize;
+        continue;
+      case 'x':
+        break;
+      default:
+        return { begin, output };
+    }
+
+    if (end - begin < codepointSize) {
+      break;
+    }
+    int32_t codepoint = readHexCodepoint(begin + 2);
+    ptrdiff_t size = codepointSize;
+    if ((0xD800 <= codepoint) && (codepoint <= 0xDBFF)) {
+      // The high surrogate must be followed by the low one
+      if ((end - begin < 2 * codepointSize) ||
+          (begin[codepointSize] != '\\') ||
+          (begin[codepointSize + 1] != 'x'))
+      {
+        break;
+      }
+      int32_t const lowSurrogate =
+        readHexCodepoint(begin + codepointSize + 2);
+      if ((lowSurrogate < 0xDC00) || (0xDFFF < lowSurrogate)) {
+        break;
+      }
+      codepoint = (codepoint << 10) + lowSurrogate - 0x35FDC00;
+      size = 2 * codepointSize;
+    } else if (codepoint < 0) {
+      break;
+    }
+
+    output = writeUtf8(output, uint32_t(codepoint));
+    begin += size;
+  }
+  return { begin, output };
+}
+
+} // namespace scanning
+} // namespace parsing
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "char_classes.hxx"
+
+namespace parsing {
+namespace scanning {
+
+//
+// Bulk scanning kernels used by the lexer hot loops.
+//
+// Each kernel has a portable scalar version and, on x86, SSE2 and AVX2
+// versions. The best available version is selected at runtime.
+//
+// UTF-8 validation of AVX2 checks whole blocks with nibble lookup
+// tables, the other versions skip ASCII runs and check multibyte
+// sequences one by one. The error position is found by the scalar code.
+//
+// Sections are skipped by blocks as well: the quote masks are turned
+// into the masks of value bytes by prefix XOR, and the braces out of
+// values are counted, so only the block with the section end is walked
+// brace by brace.
+//
+
+// Bytes skipped between tokens: whitespace and control characters
+constexpr bool isIgnored(char c)
+{
+  return char_classes::is(c, char_classes::Ignored);
+}
+
+// Bytes interrupting a plain run of value characters: value end,
+// escape and control characters
+constexpr bool isValueSpecial(char c)
+{
+  return char_classes::is(c, char_classes::ValueSpecial);
+}
+
+// Bytes defining the document structure regardless of the token
+// contents: quotes, section braces and entry separators
+constexpr bool isStructural(char c)
+{
+  return char_classes::is(c, char_classes::Structural);
+}
+
+// Returns the first byte in [begin; end) which is not ignored,
+// or end if there is none
+char const* skipIgnored(char const* begin, char const* end);
+
+// Returns the first special value byte in [begin; end),
+// or end if there is none
+char const* findValueSpecial(char const* begin, char const* end);
+
+// Returns the first structural byte in [begin; end),
+// or end if there is none
+char const* findStructural(char const* begin, char const* end);
+
+// Returns the first byte of the first invalid UTF-8 sequence
+// in [begin; end), or end if the text is valid. Overlong forms,
+// surrogates, code points above U+10FFFF and sequences truncated
+// by the range end are invalid.
+char const* findInvalidUtf8(char const* begin, char const* end);
+
+// Returns the brace closing the section opened before begin,
+// or end if the section is not closed in [begin; end). Braces in values
+// are skipped. There is no escape sequence for a quote, so a value ends
+// at the next quote. Nothing else is checked.
+char const* skipSection(char const* begin, char const* end);
+
+// Ends of the input and of the output of decodeEscapes
+struct DecodedEscapes {
+  char const* m_input;
+  char* m_output;
+};
+
+// Decodes the run of escape sequences at the begin of [begin; end)
+// to UTF-8. Decoding stops at the first byte out of escape sequences
+// and at the sequence which is wrong or truncated by the range end,
+// so the caller reports it. The output must have room for
+// end - begin bytes, decoded sequences are never longer.
+DecodedEscapes decodeEscapes(char const* begin, char const* end,
+  char* output);
+
+
+namespace scalar {
+char const* skipIgnored(char const* begin, char const* end);
+char const* findValueSpecial(char const* begin, char const* end);
+char const* findStructural(char const* begin, char const* end);
+char const* findInvalidUtf8(char const* begin, char const* end);
+char const* skipSection(char const* begin, char const* end);
+} // namespace scalar
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PARSING_HAS_SSE2 1
+
+namespace sse2 {
+char const* skipIgnored(char const* begin, char const* end);
+char const* findValueSpecial(char const* begin, char const* end);
+char const* findStructural(char const* begin, char const* end);
+char const* findInvalidUtf8(char const* begin, char const* end);
+char const* skipSection(char const* begin, char const* end);
+} // namespace sse2
+
+#else
+#define PARSING_HAS_SSE2 0
+#endif
+
+#if PARSING_HAS_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define PARSING_HAS_AVX2 1
+
+namespace avx2 {
+char const* skipIgnored(char const* begin, char const* end);
+char const* findValueSpecial(char const* begin, char const* end);
+char const* findStructural(char const* begin, char const* end);
+char const* findInvalidUtf8(char const* begin, char const* end);
+char const* skipSection(char const* begin, char const* end);
+} // namespace avx2
+
+#else
+#define PARSING_HAS_AVX2 0
+#endif
+
+// Checks if the AVX2 kernels can be used on the running CPU
+bool isAvx2Supported();
+
+} // namespace scanning
+} // namespace parsing
@@ -0,0 +1,280 @@
+#include "snapshot.hxx"
+#include "hashing.hxx"
+#include "mapped_file.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+
+namespace parsing {
+
+struct Snapshot::Header {
+  char m_magic[8];
+  uint32_t m_version;
+  uint32_t m_byteOrder; // s_byteOrder in the writer byte order
+  uint64_t m_entryCount;
+  uint64_t m_poolSize;
+  uint64_t m_sourceHash;
+  uint64_t m_checksum; // of the entry table and the pool
+};
+
+struct Snapshot::Entry {
+  uint32_t m_key; // offsets and sizes of texts in the pool
+  uint32_t m_keySize;
+  uint32_t m_value;
+  uint32_t m_valueSize;
+};
+
+namespace {
+
+constexpr char s_magic[8] = { 'P', 'A', 'R', 'S', 'N', 'A', 'P', '\0' };
+constexpr uint32_t s_version = 1;
+constexpr uint32_t s_byteOrder = 0x01020304;
+
+constexpr size_t s_alignment = 8;
+
+using hashing::hashBytes;
+
+// Same ordering as of std::string keys in the parsed tree
+bool isLess(TextView a, TextView b)
+{
+  size_t const size = std::min(a.getSize(), b.getSize());
+  int const result = (size == 0) ? 0 :
+    std::memcmp(a.getData(), b.getData(), size);
+  return (result < 0) || ((result == 0) && (a.getSize() < b.getSize()));
+}
+
+} // namespace
+
+Snapshot::Snapshot()
+  : m_file()
+  , m_header(nullptr)
+  , m_entries(nullptr)
+  , m_pool(nullptr)
+{}
+
+Snapshot::~Snapshot() = default;
+
+Snapshot::Snapshot(Snapshot&& other) noexcept
+  : m_file(std::move(other.m_file))
+  , m_header(other.m_header)
+  , m_entries(other.m_entries)
+  , m_pool(other.m_pool)
+{
+  other.close();
+}
+
+Snapshot& Snapshot::operator = (Snapshot&& other) noexcept
+{
+  if (this != &other) {
+    m_file = std::move(other.m_file);
+    m_header = other.m_header;
+    m_entries = other.m_entries;
+    m_pool = other.m_pool;
+    other.close();
+  }
+  return *this;
+}
+
+std::string Snapshot::serialize(Parser::ParsedTree const& tree,
+  uint64_t sourceHash)
+{
+  size_t poolSize = 0;
+  for (auto const& entry : tree) {
+    poolSize += entry.first.size() + entry.second.size();
+  }
+  if (std::numeric_limits<uint32_t>::max() < poolSize) {
+    return std::string();
+  }
+
+  size_t const tableSize = tree.size() * sizeof(Entry);
+  std::string image(sizeof(Header) + tableSize + poolSize, '\0');
+  char* const table = &image[sizeof(Header)];
+  char* const pool = table + tableSize;
+
+  uint32_t offset = 0;
+  auto appendText = [&] (std::string const& text) {
+    std::memcpy(pool + offset, text.data(), text.size());
+    offset += uint32_t(text.size());
+  };
+
+  char* position = table;
+  for (auto const& entry : tree) {
+    Entry record;
+    record.m_key = offset;
+    record.m_keySize = uint32_t(entry.first.size());
+    appendText(entry.first);
+    record.m_value = offset;
+    record.m_valueSize = uint32_t(entry.second.size());
+    appendText(entry.second);
+
+    std::memcpy(position, &record, sizeof(record));
+    position += sizeof(record);
+  }
+
+  Header header;
+  std::memcpy(header.m_magic, s_magic, sizeof(s_magic));
+  header.m_version = s_version;
+  header.m_byteOrder = s_byteOrder;
+  header.m_entryCount = tree.size();
+  header.m_poolSize = poolSize;
+  header.m_sourceHash = sourceHash;
+  header.m_checksum = hashBytes(table, tableSize + poolSize, s_version);
+  std::memcpy(&image[0], &header, sizeof(header));
+
+  return image;
+}
+
+bool Snapshot::writeFile(std::string const& path,
+  Parser::ParsedTree const& tree, uint64_t sourceHash)
+{
+  std::string const image = serialize(tree, sourceHash);
+  if (image.empty()) {
+    return false;
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(image.data(), std::streamsize(image.size()));
+  file.close();
+  return !file.fail();
+}
+
+uint64_t Snapshot::hashSource(char const* data, size_t size)
+{
+  return hashBytes(data, size, 0);
+}
+
+bool Snapshot::open(std::string const& path)
+{
+  close();
+
+  std::unique_ptr<MappedFile> file(new MappedFile());
+  if (!file->open(path) || !open(file->getData(), file->getSize())) {
+    return false;
+  }
+
+  m_file = std::move(file);
+  return true;
+}
+
+bool Snapshot::open(char const* data, size_t size)
+{
+  close();
+
+  if (!data || (size < sizeof(Header)) ||
+      (reinterpret_cast<uintptr_t>(data) % s_alignment != 0))
+  {
+    return false;
+  }
+
+  Header const* const header = reinterpret_cast<Header const*>(data);
+  if ((std::memcmp(header->m_magic, s_magic, sizeof(s_magic)) != 0) ||
+      (header->m_version != s_version) ||
+      (header->m_byteOrder != s_byteOrder))
+  {
+    return false;
+  }
+
+  size_t const dataSize = size - sizeof(Header);
+  if ((dataSize / sizeof(Entry) < header->m_entryCount) ||
+      (dataSize - header->m_entryCount * sizeof(Entry) !=
+        header->m_poolSize))
+  {
+    return false;
+  }
+
+  char const* const table = data + sizeof(Header);
+  if (hashBytes(table, dataSize, s_version) != header->m_checksum) {
+    return false;
+  }
+
+  Entry const* const entries = reinterpret_cast<Entry const*>(table);
+  for (size_t i = 0; i != header->m_entryCount; ++i) {
+    Entry const& entry = entries[i];
+    if ((header->m_poolSize < uint64_t(entry.m_key) + entry.m_keySize) ||
+        (header->m_poolSize < uint64_t(entry.m_value) + entry.m_valueSize))
+    {
+      return false;
+    }
+  }
+
+  m_header = header;
+  m_entries = entries;
+  m_pool = table + header->m_entryCount * sizeof(Entry);
+  return true;
+}
+
+void Snapshot::close()
+{
+  m_file.reset();
+  m_header = nullptr;
+  m_entries = nullptr;
+  m_pool = nullptr;
+}
+
+bool Snapshot::isOpen() const
+{
+  return m_header != nullptr;
+}
+
+size_t Snapshot::getEntryCount() const
+{
+  return m_header ? size_t(m_header->m_entryCount) : 0;
+}
+
+TextView Snapshot::getKey(size_t index) const
+{
+  Entry const& entry = getEntry(index);
+  return getText(entry.m_key, entry.m_keySize);
+}
+
+TextView Snapshot::getValue(size_t index) const
+{
+  Entry const& entry = getEntry(index);
+  return getText(entry.m_value, entry.m_valueSize);
+}
+
+bool Snapshot::find(TextView key, TextView& value) const
+{
+  size_t first = 0;
+  size_t count = getEntryCount();
+  while (count != 0) {
+    size_t const step = count / 2;
+    if (isLess(getKey(first + step), key)) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+
+  if ((first == getEntryCount()) || (getKey(first) != key)) {
+    return false;
+  }
+  value = getValue(first);
+  return true;
+}
+
+uint64_t Snapshot::getSourceHash() const
+{
+  return m_header ? m_header->m_sourceHash : 0;
+}
+
+bool Snapshot::isMadeFrom(char const* data, size_t size) const
+{
+  return m_header && (m_header->m_sourceHash == hashSource(data, size));
+}
+
+Snapshot::Entry const& Snapshot::getEntry(size_t index) const
+{
+  return m_entries[index];
+}
+
+TextView Snapshot::getText(uint32_t offset, uint32_t size) const
+{
+  return TextView(m_pool + offset, size);
+}
+
+} // namespace parsing
@@ -0,0 +1,128 @@
+#include "thread_pool.hxx"
+
+#include <algorithm>
+
+
+namespace parsing {
+
+ThreadPool::ThreadPool(size_t workerCount)
+  : m_mutex()
+  , m_jobAdded()
+  , m_jobFinished()
+  , m_jobs()
+  , m_stopping(false)
+  , m_workers()
+{
+  m_workers.reserve(workerCount);
+  for (size_t i = 0; i != workerCount; ++i) {
+    m_workers.emplace_back([this] { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_jobAdded.notify_all();
+
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::getWorkerCount() const
+{
+  return m_workers.size();
+}
+
+void ThreadPool::run(size_t taskCount, size_t maxThreads, Task const& task)
+{
+  maxThreads = std::max<size_t>(maxThreads, 1);
+
+  Job job;
+  job.m_task = &task;
+  job.m_taskCount = taskCount;
+  job.m_maxThreads = maxThreads;
+  job.m_nextTask = 0;
+  job.m_threadCount = 1; // the calling thread
+  job.m_activeWorkers = 0;
+
+  size_t const helperCount =
+    std::min({ maxThreads - 1, taskCount, m_workers.size() });
+  if (helperCount != 0) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_jobs.push_back(&job);
+    }
+    for (size_t i = 0; i != helperCount; ++i) {
+      m_jobAdded.notify_one();
+    }
+  }
+
+  runTasks(job, 0);
+
+  if (helperCount != 0) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    removeJob(job);
+    m_jobFinished.wait(lock, [&] { return job.m_activeWorkers == 0; });
+  }
+}
+
+ThreadPool& ThreadPool::getShared()
+{
+  static ThreadPool pool(
+    std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1);
+  return pool;
+}
+
+void ThreadPool::work()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_jobAdded.wait(lock, [&] { return m_stopping || !m_jobs.empty(); });
+    if (m_stopping) {
+      return;
+    }
+
+    Job& job = *m_jobs.front();
+    size_t const threadIndex = job.m_threadCount++;
+    ++job.m_activeWorkers;
+    if (job.m_threadCount == job.m_maxThreads) {
+      m_jobs.pop_front();
+    }
+
+    lock.unlock();
+    runTasks(job, threadIndex);
+    lock.lock();
+
+    // All the tasks are claimed, so there is no work for new threads
+    removeJob(job);
+    --job.m_activeWorkers;
+    if (job.m_activeWorkers == 0) {
+      m_jobFinished.notify_all();
+    }
+  }
+}
+
+void ThreadPool::runTasks(Job& job, size_t threadIndex)
+{
+  while (true) {
+    size_t const taskIndex = job.m_nextTask.fetch_add(1);
+    if (job.m_taskCount <= taskIndex) {
+      return;
+    }
+    (*job.m_task)(taskIndex, threadIndex);
+  }
+}
+
+void ThreadPool::removeJob(Job& job)
+{
+  auto const iJob = std::find(m_jobs.begin(), m_jobs.end(), &job);
+  if (iJob != m_jobs.end()) {
+    m_jobs.erase(iJob);
+  }
+}
+
+} // namespace parsing
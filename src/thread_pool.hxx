@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace parsing {
+
+// Pool of worker threads running indexed tasks.
+//
+// Workers and the calling thread claim task indices from a shared atomic
+// counter, so idle threads pick up the remaining work of busy ones.
+// Several jobs may run at once, each one is finished before its caller
+// returns. Tasks must not throw.
+class ThreadPool {
+public:
+  using Task = std::function<void (size_t taskIndex, size_t threadIndex)>;
+
+  explicit ThreadPool(size_t workerCount);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator = (ThreadPool const&) = delete;
+
+  size_t getWorkerCount() const;
+
+  // Runs the task for every index in [0; taskCount) on at most
+  // 'maxThreads' threads, including the calling one. Thread indices
+  // passed to the task are unique among the threads running the job
+  // and are less than maxThreads.
+  void run(size_t taskCount, size_t maxThreads, Task const& task);
+
+  // Returns the process-wide pool with a worker per hardware thread,
+  // minus the calling one
+  static ThreadPool& getShared();
+
+private:
+  struct Job {
+    Task const* m_task;
+    size_t m_taskCount;
+    size_t m_maxThreads;
+    std::atomic<size_t> m_nextTask;
+    size_t m_threadCount; // threads joined the job, guarded by the mutex
+    size_t m_activeWorkers; // guarded by the mutex
+  };
+
+  void work();
+  static void runTasks(Job& job, size_t threadIndex);
+  void removeJob(Job& job);
+
+  std::mutex m_mutex;
+  std::condition_variable m_jobAdded;
+  std::condition_variable m_jobFinished;
+  std::deque<Job*> m_jobs;
+  bool m_stopping;
+
+  std::vector<std::thread> m_workers;
+};
+
+} // namespace parsing
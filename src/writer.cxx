@@ -0,0 +1,304 @@
+#include "writer.hxx"
+#include "scanning.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#else
+#include <climits>
+#include <io.h>
+#endif
+
+
+namespace parsing {
+
+namespace {
+
+// Size of the blocks written to file descriptors
+constexpr size_t s_blockSize = 64 * 1024;
+
+bool writeAll(int fd, char const* data, size_t size)
+{
+  while (size != 0) {
+#if defined(__unix__) || defined(__APPLE__)
+    ssize_t const written = ::write(fd, data, size);
+    if ((written < 0) && (errno == EINTR)) {
+      continue;
+    }
+#else
+    int const written =
+      ::_write(fd, data, unsigned(std::min<size_t>(size, INT_MAX)));
+#endif
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= size_t(written);
+  }
+  return true;
+}
+
+} // namespace
+
+
+class Writer::impl {
+public:
+  using Tree = Parser::ParsedTree;
+  using Iterator = Tree::const_iterator;
+
+  // Output to the string. With a file descriptor, the string is
+  // the block buffer, which is flushed when full.
+  impl(Tree const& tree, WritingStyle style, std::string& output, int fd)
+    : m_tree(tree)
+    , m_style(style)
+    , m_output(output)
+    , m_size(output.size())
+    , m_fd(fd)
+    , m_failed(false)
+    , m_probe()
+    , m_written()
+  {}
+
+  bool writeDocument()
+  {
+    writeSection(m_tree.begin(), 0, 0);
+    if (m_style == WritingStyle::Pretty) {
+      append('\n');
+    }
+    return finish();
+  }
+
+private:
+  // Writes the section of the entries from the first one, which have
+  // the same key prefix of the size. Returns the end of the entries.
+  //
+  // Sections are written in a single pass over the sorted keys. Only
+  // digits are ordered before the separator, so the children of a key
+  // directly follow it, unless there are keys of the key and digits.
+  // Such children are searched and written ahead, and then skipped.
+  Iterator writeSection(Iterator first, size_t prefixSize, size_t depth)
+  {
+    append('{');
+
+    Iterator const iEnd = m_tree.end();
+    bool isEmpty = true;
+    Iterator iEntry = first;
+    while ((iEntry != iEnd) && hasPrefix(iEntry->first, first->first,
+      prefixSize))
+    {
+      if (!m_written.empty() && (m_written.back().first == iEntry)) {
+        iEntry = m_written.back().second;
+        m_written.pop_back();
+        continue;
+      }
+
+      // Keys with the separator are of the children of a section,
+      // which has no own entry
+      std::string const& key = iEntry->first;
+      size_t const nameEnd =
+        key.find(Parser::s_categorySeparator, prefixSize);
+      bool const isSection = (nameEnd != std::string::npos);
+      size_t const keyEnd = isSection ? nameEnd : key.size();
+
+      if (!isEmpty) {
+        append(',');
+      }
+      isEmpty = false;
+      writeLineBreak(depth + 1);
+      append(key.data() + prefixSize, keyEnd - prefixSize);
+      append(Parser::s_categorySeparator);
+      if (m_style == WritingStyle::Pretty) {
+        append(' ');
+      }
+
+      Iterator iNext = std::next(iEntry);
+      if (isSection) {
+        iNext = writeSection(iEntry, keyEnd + 1, depth + 1);
+      } else if ((iNext == iEnd) || !hasPrefix(iNext->first, key,
+        key.size()))
+      {
+        writeValue(iEntry->second);
+      } else if (iNext->first[key.size()] == Parser::s_categorySeparator) {
+        iNext = writeSection(iNext, key.size() + 1, depth + 1);
+      } else {
+        writeAhead(iEntry, depth + 1);
+      }
+      iEntry = iNext;
+    }
+
+    if (!isEmpty) {
+      writeLineBreak(depth);
+    }
+    append('}');
+    return iEntry;
+  }
+
+  // Writes the entry, which is followed by the keys made of its key
+  // and digits, so its children are searched
+  void writeAhead(Iterator entry, size_t depth)
+  {
+    std::string const& key = entry->first;
+    m_probe.assign(key);
+    m_probe.push_back(Parser::s_categorySeparator);
+    Iterator const iChildren = m_tree.lower_bound(m_probe);
+    if ((iChildren == m_tree.end()) ||
+        !hasPrefix(iChildren->first, m_probe, m_probe.size()))
+    {
+      writeValue(entry->second);
+      return;
+    }
+
+    Iterator const iChildrenEnd =
+      writeSection(iChildren, key.size() + 1, depth);
+    m_written.emplace_back(iChildren, iChildrenEnd);
+  }
+
+  static bool hasPrefix(std::string const& key, std::string const& prefix,
+    size_t size)
+  {
+    return (size <= key.size()) && (key.compare(0, size, prefix, 0, size) == 0);
+  }
+
+  void writeLineBreak(size_t depth)
+  {
+    if (m_style == WritingStyle::Pretty) {
+      char* const output = reserve(1 + 2 * depth);
+      output[0] = '\n';
+      std::memset(output + 1, ' ', 2 * depth);
+      m_size += 1 + 2 * depth;
+    }
+  }
+
+  void writeValue(std::string const& value)
+  {
+    append('"');
+
+    // Runs of plain characters are copied in bulk
+    char const* current = value.data();
+    char const* const end = current + value.size();
+    while (true) {
+      char const* const runEnd = scanning::findValueSpecial(current, end);
+      append(current, size_t(runEnd - current));
+      if (runEnd == end) {
+        break;
+      }
+      writeEscaped(*runEnd);
+      current = runEnd + 1;
+    }
+
+    append('"');
+  }
+
+  void writeEscaped(char c)
+  {
+    switch (c) {
+      case '\n':
+        append("\\n", 2);
+        return;
+      case '\r':
+        append("\\r", 2);
+        return;
+      case '\\':
+        append("\\\\", 2);
+        return;
+      default:
+        break;
+    }
+
+    // Quotes and other control characters, like '\x0022'
+    constexpr char digits[] = "0123456789abcdef";
+    unsigned char const code = static_cast<unsigned char>(c);
+    char const escaped[] = {
+      '\\', 'x', '0', '0', digits[code >> 4], digits[code & 0xF]
+    };
+    append(escaped, sizeof(escaped));
+  }
+
+  // Returns the place for the bytes at the output end
+  char* reserve(size_t size)
+  {
+    if (m_output.size() < m_size + size) {
+      if ((m_fd >= 0) && (m_size != 0)) {
+        flush();
+      }
+      size_t const capacity = (m_fd >= 0) ? s_blockSize : 2 * m_size;
+      m_output.resize(std::max(capacity, m_size + size));
+    }
+    return &m_output[m_size];
+  }
+
+  void append(char const* data, size_t size)
+  {
+    // Large texts are written to the file descriptor directly
+    if ((m_fd >= 0) && (s_blockSize <= size)) {
+      flush();
+      m_failed = m_failed || !writeAll(m_fd, data, size);
+      return;
+    }
+    if (size != 0) {
+      std::memcpy(reserve(size), data, size);
+      m_size += size;
+    }
+  }
+
+  void append(char c)
+  {
+    *reserve(1) = c;
+    ++m_size;
+  }
+
+  void flush()
+  {
+    m_failed = m_failed || !writeAll(m_fd, m_output.data(), m_size);
+    m_size = 0;
+  }
+
+  bool finish()
+  {
+    if (m_fd >= 0) {
+      flush();
+    }
+    m_output.resize(m_size);
+    return !m_failed;
+  }
+
+  Tree const& m_tree;
+  WritingStyle m_style;
+
+  std::string& m_output;
+  size_t m_size; // used part of the output, the rest is reserved
+  int m_fd;
+  bool m_failed;
+
+  std::string m_probe; // key prefix for the lookups
+
+  // Children written ahead of their keys: the ranges of the keys
+  // to skip. They are met in the reverse order.
+  std::vector<std::pair<Iterator, Iterator>> m_written;
+};
+
+
+Writer::Writer(WritingStyle style)
+  : m_style(style)
+{}
+
+void Writer::write(Parser::ParsedTree const& tree, std::string& output) const
+{
+  impl(tree, m_style, output, -1).writeDocument();
+}
+
+bool Writer::write(Parser::ParsedTree const& tree, int fd) const
+{
+  if (fd < 0) {
+    return false;
+  }
+  std::string buffer;
+  return impl(tree, m_style, buffer, fd).writeDocument();
+}
+
+} // namespace parsing
@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include "document.hxx"
+
+#include <sstream>
+#include <string>
+
+
+using namespace parsing;
+
+TEST(DocumentTests, can_create)
+{
+  Document document;
+
+  EXPECT_EQ(0u, document.getRoot().getChildCount());
+  EXPECT_EQ(nullptr, document.findPath("key"));
+}
+
+TEST(DocumentTests, can_parse_nested_sections)
+{
+  std::string const line =
+    "{ b: \"1\", a: { y: \"x\\ny\", x: { } }, c: \"2\" }";
+  Parser parser(line.data(), line.size());
+  Document document;
+
+  Parser::ParsingResult const result = document.parse(parser);
+
+  ASSERT_TRUE(result.m_success);
+  DocumentNode const& root = document.getRoot();
+  ASSERT_TRUE(root.isSection());
+  ASSERT_EQ(3u, root.getChildCount());
+  EXPECT_EQ(std::string("a"), root.getChild(0).getKey());
+  EXPECT_EQ(std::string("b"), root.getChild(1).getKey());
+  EXPECT_EQ(std::string("c"), root.getChild(2).getKey());
+
+  DocumentNode const* const section = root.find("a");
+  ASSERT_NE(nullptr, section);
+  EXPECT_TRUE(section->isSection());
+  ASSERT_EQ(2u, section->getChildCount());
+  EXPECT_EQ(std::string("x\ny"), section->find("y")->getValue());
+
+  DocumentNode const* const empty = document.findPath("a:x");
+  ASSERT_NE(nullptr, empty);
+  EXPECT_TRUE(empty->isSection());
+  EXPECT_EQ(0u, empty->getChildCount());
+}
+
+TEST(DocumentTests, can_find_by_path)
+{
+  std::string const line = "{ a: { b: { c: \"deep\" } } }";
+  std::stringstream ss(line);
+  Parser parser(ss);
+  Document document;
+
+  ASSERT_TRUE(document.parse(parser).m_success);
+
+  DocumentNode const* const node = document.findPath("a:b:c");
+  ASSERT_NE(nullptr, node);
+  EXPECT_FALSE(node->isSection());
+  EXPECT_EQ(std::string("deep"), node->getValue());
+  EXPECT_EQ(nullptr, document.findPath("a:b:d"));
+  EXPECT_EQ(nullptr, document.findPath("a:b:c:d"));
+}
+
+TEST(DocumentTests, finds_first_of_duplicate_keys)
+{
+  std::string const line = "{ a: \"1\", a: \"2\" }";
+  Parser parser(line.data(), line.size());
+  Document document;
+
+  ASSERT_TRUE(document.parse(parser).m_success);
+
+  EXPECT_EQ(2u, document.getRoot().getChildCount());
+  EXPECT_EQ(std::string("1"), document.findPath("a")->getValue());
+}
+
+TEST(DocumentTests, is_empty_after_failure)
+{
+  std::string const line = "{ a: \"1\", b: }";
+  Parser parser(line.data(), line.size());
+  Document document;
+
+  ASSERT_FALSE(document.parse(parser).m_success);
+
+  EXPECT_EQ(0u, document.getRoot().getChildCount());
+  EXPECT_EQ(0u, document.getArena().getReservedSize());
+}
+
+TEST(DocumentTests, keeps_nodes_after_move)
+{
+  std::string const line = "{ a: \"1\" }";
+  Parser parser(line.data(), line.size());
+  Document document;
+  ASSERT_TRUE(document.parse(parser).m_success);
+
+  Document moved(std::move(document));
+
+  EXPECT_EQ(0u, document.getRoot().getChildCount());
+  EXPECT_EQ(std::string("1"), moved.findPath("a")->getValue());
+}
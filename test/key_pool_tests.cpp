@@ -0,0 +1,181 @@
+#include "gtest/gtest.h"
+
+#include "key_pool.hxx"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace parsing;
+
+TEST(KeyPoolTests, can_create)
+{
+  KeyPool const pool;
+  KeyHandle handle;
+
+  EXPECT_FALSE(pool.find("key", handle));
+  EXPECT_EQ(0u, pool.getStats().m_keyCount);
+}
+
+TEST(KeyPoolTests, can_intern_keys)
+{
+  KeyPool pool;
+
+  KeyHandle const a = pool.intern("a:b");
+  KeyHandle const b = pool.intern("b");
+  std::string const copy = "a:b";
+
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, pool.intern(copy));
+  EXPECT_EQ(std::string("a:b"), pool.getKey(a));
+  EXPECT_EQ(std::string("b"), pool.getKey(b));
+
+  KeyHandle handle;
+  ASSERT_TRUE(pool.find("b", handle));
+  EXPECT_EQ(b, handle);
+  EXPECT_FALSE(pool.find("c", handle));
+
+  KeyPool::Stats const stats = pool.getStats();
+  EXPECT_EQ(2u, stats.m_keyCount);
+  EXPECT_EQ(4u, stats.m_keyBytes);
+  EXPECT_LT(stats.m_keyBytes, stats.m_reservedBytes);
+}
+
+TEST(KeyPoolTests, can_intern_empty_key)
+{
+  KeyPool pool;
+
+  KeyHandle const handle = pool.intern(TextView());
+
+  EXPECT_EQ(handle, pool.intern(""));
+  EXPECT_EQ(std::string(), pool.getKey(handle));
+  EXPECT_EQ(1u, pool.getStats().m_keyCount);
+}
+
+TEST(KeyPoolTests, keeps_keys_of_many_chunks)
+{
+  KeyPool pool;
+  std::vector<KeyHandle> handles;
+  for (int i = 0; i != 100000; ++i) {
+    handles.push_back(pool.intern("key_" + std::to_string(i)));
+  }
+
+  for (int i = 0; i != 100000; ++i) {
+    ASSERT_EQ("key_" + std::to_string(i), pool.getKey(handles[i]));
+  }
+  EXPECT_EQ(100000u, pool.getStats().m_keyCount);
+}
+
+TEST(KeyPoolTests, can_intern_from_several_threads)
+{
+  KeyPool pool;
+  size_t const threadCount = 4;
+  size_t const keyCount = 10000;
+
+  // Every thread interns the same keys in its own order
+  std::vector<std::vector<KeyHandle>> handles(threadCount,
+    std::vector<KeyHandle>(keyCount));
+  std::vector<std::thread> threads;
+  for (size_t thread = 0; thread != threadCount; ++thread) {
+    threads.emplace_back([&, thread] {
+      for (size_t i = 0; i != keyCount; ++i) {
+        size_t const key = (i * 7919 + thread * 2503) % keyCount;
+        handles[thread][key] = pool.intern("key_" + std::to_string(key));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(keyCount, pool.getStats().m_keyCount);
+  for (size_t key = 0; key != keyCount; ++key) {
+    for (size_t thread = 1; thread != threadCount; ++thread) {
+      ASSERT_EQ(handles[0][key], handles[thread][key]);
+    }
+    ASSERT_EQ("key_" + std::to_string(key), pool.getKey(handles[0][key]));
+  }
+}
+
+TEST(KeyPoolTests, can_parse_with_shared_keys)
+{
+  std::string const first = "{ a: \"1\", b: { c: \"2\" } }";
+  std::string const second = "{ b: { c: \"3\" }, d: \"4\" }";
+  KeyPool pool;
+
+  Parser firstParser(first.data(), first.size());
+  Parser::InternedParsingResult const firstResult =
+    firstParser.parse(pool);
+  Parser secondParser(second.data(), second.size());
+  Parser::InternedParsingResult const secondResult =
+    secondParser.parse(pool);
+
+  ASSERT_TRUE(firstResult.m_success);
+  ASSERT_TRUE(secondResult.m_success);
+  EXPECT_EQ(3u, firstResult.m_tree.size());
+  EXPECT_EQ(3u, secondResult.m_tree.size());
+  EXPECT_EQ(4u, pool.getStats().m_keyCount);
+
+  KeyHandle key;
+  ASSERT_TRUE(pool.find("b:c", key));
+  EXPECT_EQ("2", firstResult.m_tree.at(key));
+  EXPECT_EQ("3", secondResult.m_tree.at(key));
+  ASSERT_TRUE(pool.find("b", key));
+  EXPECT_EQ("", secondResult.m_tree.at(key));
+  EXPECT_EQ(0u, firstResult.m_tree.count(pool.intern("d")));
+}
+
+TEST(KeyPoolTests, reports_interned_parsing_error)
+{
+  std::string const line = "{ a: \"1\",\n}";
+  KeyPool pool;
+  Parser parser(line.data(), line.size());
+
+  Parser::InternedParsingResult const result = parser.parse(pool);
+
+  EXPECT_FALSE(result.m_success);
+  EXPECT_TRUE(result.m_tree.empty());
+  EXPECT_EQ(2u, result.m_error.m_line);
+  EXPECT_EQ(2u, result.m_error.m_column);
+}
+
+TEST(KeyPoolTests, can_measure_tree_memory)
+{
+  std::string const longValue(100, 'v');
+  Parser::ParsedTree tree;
+  EXPECT_EQ(0u, measureTreeMemory(tree).m_allocationCount);
+  EXPECT_EQ(0u, measureTreeMemory(tree).m_allocatedBytes);
+
+  tree.emplace("a", "1");
+  TreeMemory const memory = measureTreeMemory(tree);
+  tree.emplace("b", longValue);
+  TreeMemory const longMemory = measureTreeMemory(tree);
+
+  EXPECT_EQ(1u, memory.m_allocationCount);
+  EXPECT_LT(sizeof(Parser::ParsedTree::value_type), memory.m_allocatedBytes);
+  EXPECT_EQ(3u, longMemory.m_allocationCount);
+  EXPECT_LE(2 * memory.m_allocatedBytes + longValue.size(),
+    longMemory.m_allocatedBytes);
+}
+
+TEST(KeyPoolTests, interned_tree_takes_less_memory)
+{
+  std::string const line =
+    "{ section: { subsection: { long_entry_key: \"1\" } } }";
+  KeyPool pool;
+
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult const result = parser.parse();
+  parser.reset(line.data(), line.size());
+  Parser::InternedParsingResult const interned = parser.parse(pool);
+
+  ASSERT_TRUE(result.m_success);
+  ASSERT_TRUE(interned.m_success);
+  TreeMemory const memory = measureTreeMemory(result.m_tree);
+  TreeMemory const internedMemory = measureTreeMemory(interned.m_tree);
+  // Only the nodes, the long keys are in the pool
+  EXPECT_EQ(3u, internedMemory.m_allocationCount);
+  EXPECT_LT(internedMemory.m_allocationCount, memory.m_allocationCount);
+  EXPECT_LT(internedMemory.m_allocatedBytes, memory.m_allocatedBytes);
+}
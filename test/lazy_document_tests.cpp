@@ -0,0 +1,184 @@
+#include "gtest/gtest.h"
+
+#include "lazy_document.hxx"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+using namespace parsing;
+
+TEST(LazyDocumentTests, can_create)
+{
+  LazyDocument document;
+
+  EXPECT_FALSE(document.getRoot());
+  EXPECT_FALSE(document.findPath("key"));
+}
+
+TEST(LazyDocumentTests, can_parse_nested_sections)
+{
+  std::string const line =
+    "{ b: \"1\", a: { y: \"x\\ny\", x: { } }, c: \"2\" }";
+  LazyDocument document;
+
+  Parser::ParsingResult const result =
+    document.parse(line.data(), line.size());
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(6u, document.getNodeCount());
+  LazyNode const root = document.getRoot();
+  ASSERT_TRUE(root.isSection());
+  ASSERT_EQ(3u, root.getChildCount());
+
+  std::vector<std::string> keys;
+  for (LazyNode child = root.getFirstChild(); child;
+      child = child.getNextSibling())
+  {
+    keys.push_back(child.getKey().toString());
+  }
+  EXPECT_EQ(std::vector<std::string>({ "b", "a", "c" }), keys);
+
+  LazyNode const section = root.find("a");
+  ASSERT_TRUE(section);
+  EXPECT_TRUE(section.isSection());
+  ASSERT_EQ(2u, section.getChildCount());
+  EXPECT_EQ(std::string("x\ny"), section.find("y").getValue());
+
+  LazyNode const empty = document.findPath("a:x");
+  ASSERT_TRUE(empty);
+  EXPECT_TRUE(empty.isSection());
+  EXPECT_EQ(0u, empty.getChildCount());
+  EXPECT_FALSE(empty.getFirstChild());
+  EXPECT_FALSE(document.findPath("a:z"));
+}
+
+TEST(LazyDocumentTests, references_plain_values_in_input)
+{
+  std::string const line = "{ a: \"plain\", b: \"esc\\x0041ped\" }";
+  LazyDocument document;
+
+  ASSERT_TRUE(document.parse(line.data(), line.size()).m_success);
+
+  TextView const plain = document.findPath("a").getValue();
+  EXPECT_EQ(line.data() + 6, plain.getData());
+  TextView const escaped = document.findPath("b").getValue();
+  EXPECT_EQ(std::string("escAped"), escaped);
+  EXPECT_EQ(escaped.getData(), document.findPath("b").getValue().getData());
+}
+
+TEST(LazyDocumentTests, finds_first_of_duplicate_keys)
+{
+  std::string const line = "{ a: \"1\", a: \"2\" }";
+  LazyDocument document;
+
+  ASSERT_TRUE(document.parse(line.data(), line.size()).m_success);
+
+  EXPECT_EQ(std::string("1"), document.findPath("a").getValue());
+}
+
+TEST(LazyDocumentTests, accepts_same_inputs_as_parser)
+{
+  for (std::string const line : {
+    "\xEF\xBB\xBF{ a: \"1\" }",
+    "{ a: \"1\" } trailing",
+    "{ a: \"\\xD83D\\xDE00\" }",
+    "{ a: \"\\xDE00\" }",
+    "{ }",
+    "",
+    "{",
+    "{ a }",
+    "{ a: \"1\", }",
+    "{ a: \"1\" b: \"2\" }",
+    "{ a: \"1\\q\" }",
+    "{ a: \"1\\x00\" }",
+    "{ a: \"\\xD83D\" }",
+    "{ a: \"\\xD83D\\x0041\" }",
+    "{ a: \"1\n\" }",
+    "{ a#: \"1\" }",
+    "{ a: { b: \"1\" }",
+    "\xEF\xBB{ }"
+  }) {
+    Parser parser(line.data(), line.size());
+    Parser::ParsingResult const expected = parser.parse();
+    LazyDocument document;
+
+    Parser::ParsingResult const result =
+      document.parse(line.data(), line.size());
+
+    ASSERT_EQ(expected.m_success, result.m_success) << line;
+    if (!expected.m_success) {
+      EXPECT_TRUE(expected.m_error.m_kind == result.m_error.m_kind) << line;
+      EXPECT_EQ(expected.m_error.m_position, result.m_error.m_position)
+        << line;
+      EXPECT_FALSE(document.getRoot());
+    }
+  }
+}
+
+TEST(LazyDocumentTests, accepts_same_damaged_inputs_as_parser)
+{
+  // Every byte of the document is dropped in turn
+  std::string const line =
+    "\xEF\xBB\xBF{ a: \"1\\n\", b: { c: \"\\x0041\", d: { } }, e: \"\" }";
+
+  for (size_t position = 0; position != line.size(); ++position) {
+    std::string damaged = line;
+    damaged.erase(position, 1);
+    Parser parser(damaged.data(), damaged.size());
+    Parser::ParsingResult const expected = parser.parse();
+    LazyDocument document;
+
+    Parser::ParsingResult const result =
+      document.parse(damaged.data(), damaged.size());
+
+    ASSERT_EQ(expected.m_success, result.m_success) << damaged;
+    if (!expected.m_success) {
+      EXPECT_TRUE(expected.m_error.m_kind == result.m_error.m_kind)
+        << damaged;
+      EXPECT_EQ(expected.m_error.m_position, result.m_error.m_position)
+        << damaged;
+    }
+  }
+}
+
+TEST(LazyDocumentTests, can_not_parse_too_deep_nesting)
+{
+  std::string line;
+  for (size_t i = 0; i != Parser::s_maxSectionDepth; ++i) {
+    line += "{ k: ";
+  }
+  line += "{ }";
+  line += std::string(Parser::s_maxSectionDepth, '}');
+  LazyDocument document;
+
+  Parser::ParsingResult const result =
+    document.parse(line.data(), line.size());
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(ParsingErrorKind::NestingTooDeep == result.m_error.m_kind);
+}
+
+TEST(LazyDocumentTests, can_not_parse_too_large_input)
+{
+  // Such sizes can not be passed on 32-bit platforms
+  if (sizeof(size_t) <= sizeof(uint32_t)) {
+    return;
+  }
+
+  // The size is checked before the data is read
+  char const data[] = "{ }";
+  size_t const size = size_t(std::numeric_limits<uint32_t>::max()) + 1;
+  LazyDocument document;
+
+  Parser::ParsingResult const result = document.parse(data, size);
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(ParsingErrorKind::InputTooLarge == result.m_error.m_kind);
+  EXPECT_EQ(0, result.m_error.m_position);
+  EXPECT_EQ(0u, result.m_error.m_line);
+  EXPECT_EQ(0u, result.m_error.m_column);
+  EXPECT_EQ(0u, document.getNodeCount());
+}
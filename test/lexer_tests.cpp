@@ -260,3 +260,180 @@ TEST(LexerTests, can_parse_entry_separator)
 
   ASSERT_TRUE(TokenKind::EntrySeparator == token.getKind());
 }
+
+TEST(LexerTests, can_parse_eof_from_buffer)
+{
+  Lexer lexer(nullptr, 0);
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::ParseEnd == token.getKind());
+}
+
+TEST(LexerTests, can_parse_key_from_buffer)
+{
+  std::string const keyName = "key";
+  std::string const line = "  " + keyName + " :";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Key == token.getKind());
+  EXPECT_EQ(keyName, token.getText());
+  EXPECT_TRUE(TokenKind::KeyValueSeparator == lexer.getNext().getKind());
+}
+
+TEST(LexerTests, can_parse_value_with_escaped_chars_from_buffer)
+{
+  std::string const escapedValue = "ab\\r \\n \\\\ \\x1234cd";
+  std::string const unescapedValue = u8"ab\r \n \\ \U00001234cd";
+  std::string const line = "\"" + escapedValue + "\"";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Value == token.getKind());
+  EXPECT_EQ(unescapedValue, token.getText());
+}
+
+TEST(LexerTests, can_not_parse_unterminated_value_from_buffer)
+{
+  std::string const line = "\"value";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::ParseError == token.getKind());
+}
+
+TEST(LexerTests, can_parse_utf8_bom_from_buffer)
+{
+  std::string const value = "vqa";
+  std::string const line = "\xEF\xBB\xBF" "\"" + value + "\"";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Value == token.getKind());
+  EXPECT_EQ(value, token.getText());
+}
+
+TEST(LexerTests, key_from_buffer_references_input)
+{
+  std::string const line = "key:";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Key == token.getKind());
+  EXPECT_FALSE(token.isOwning());
+  EXPECT_EQ(line.data(), token.getText().getData());
+}
+
+TEST(LexerTests, unescaped_value_from_buffer_references_input)
+{
+  std::string const line = "\"value\"";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Value == token.getKind());
+  EXPECT_FALSE(token.isOwning());
+  EXPECT_EQ(line.data() + 1, token.getText().getData());
+}
+
+TEST(LexerTests, escaped_value_from_buffer_is_owning)
+{
+  std::string const line = "\"va\\nlue\"";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Value == token.getKind());
+  EXPECT_TRUE(token.isOwning());
+  EXPECT_EQ(std::string("va\nlue"), token.getText());
+}
+
+TEST(LexerTests, reports_error_kind)
+{
+  std::string const line = "\"va\\qlue\"";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::ParseError == token.getKind());
+  EXPECT_FALSE(token.isOwning());
+  EXPECT_TRUE(LexingErrorKind::UnknownEscapeSequence == lexer.getErrorKind());
+  EXPECT_EQ("Parse error at position 4: Unknown escape sequence",
+    lexer.getErrorMessage());
+}
+
+TEST(LexerTests, reports_unexpected_data_end)
+{
+  std::string const line = "\"value";
+  std::stringstream ss(line);
+  Lexer lexer(ss);
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::ParseError == token.getKind());
+  EXPECT_TRUE(LexingErrorKind::UnexpectedDataEnd == lexer.getErrorKind());
+}
+
+TEST(LexerTests, has_no_error_message_without_error)
+{
+  std::string const line = "key:";
+  Lexer lexer(line.data(), line.size());
+
+  lexer.getCurrent();
+
+  EXPECT_TRUE(LexingErrorKind::None == lexer.getErrorKind());
+  EXPECT_TRUE(lexer.getErrorMessage().empty());
+}
+
+TEST(LexerTests, can_not_parse_invalid_utf8_with_validation)
+{
+  for (std::string const value : {
+    "over\xC0\xAFlong", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+    "trunc\xE4\xB8", "trunc\xE4\xB8\\n"
+  }) {
+    std::string const line = "\"" + value + "\"";
+    Lexer lexer(line.data(), line.size());
+    lexer.setUtf8Validation(true);
+    std::stringstream ss(line);
+    Lexer streamLexer(ss);
+    streamLexer.setUtf8Validation(true);
+
+    for (Lexer* current : { &lexer, &streamLexer }) {
+      Token token = current->getCurrent();
+
+      ASSERT_TRUE(TokenKind::ParseError == token.getKind()) << value;
+      EXPECT_TRUE(LexingErrorKind::InvalidUtf8 == current->getErrorKind());
+    }
+  }
+}
+
+TEST(LexerTests, can_parse_valid_utf8_with_validation)
+{
+  std::string const value = u8"\u0416\u4E2D\U0001F600";
+  std::string const line = "\"" + value + "\\n\"";
+  Lexer lexer(line.data(), line.size());
+  lexer.setUtf8Validation(true);
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Value == token.getKind());
+  EXPECT_EQ(value + "\n", token.getText());
+}
+
+TEST(LexerTests, can_parse_invalid_utf8_without_validation)
+{
+  std::string const value = "over\xC0\xAFlong";
+  std::string const line = "\"" + value + "\"";
+  Lexer lexer(line.data(), line.size());
+
+  Token token = lexer.getCurrent();
+
+  ASSERT_TRUE(TokenKind::Value == token.getKind());
+  EXPECT_EQ(value, token.getText());
+}
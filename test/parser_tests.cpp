@@ -2,13 +2,94 @@
 
 #include "parser.hxx"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <map>
+#include <istream>
 #include <sstream>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <utility>
+#include <vector>
 
 
 using namespace parsing;
 
+namespace {
+
+// Non-seekable stream buffer delivering data in small portions, like a pipe
+class PipeBuffer : public std::streambuf {
+public:
+  PipeBuffer(std::string const& data, size_t portionSize)
+    : m_data(data)
+    , m_position(0)
+    , m_portionSize(portionSize)
+  {}
+
+protected:
+  int_type underflow() override
+  {
+    if (m_position == m_data.size()) {
+      return traits_type::eof();
+    }
+    char* const portion = &m_data[m_position];
+    size_t const size = std::min(m_portionSize, m_data.size() - m_position);
+    m_position += size;
+    setg(portion, portion, portion + size);
+    return traits_type::to_int_type(*portion);
+  }
+
+private:
+  std::string m_data;
+  size_t m_position;
+  size_t m_portionSize;
+};
+
+// Records parsing events as text lines
+class RecordingHandler : public ParsingHandler {
+public:
+  void onSectionBegin(TextView key) override
+  {
+    m_events.push_back("begin " + key.toString());
+  }
+
+  void onSectionEnd() override
+  {
+    m_events.push_back("end");
+  }
+
+  void onEntry(TextView key, TextView value) override
+  {
+    m_events.push_back("entry " + key.toString() + "=" + value.toString());
+  }
+
+  std::vector<std::string> m_events;
+};
+
+// Builds a document large enough to be split for parallel parsing.
+// Values contain structural characters, some keys are repeated.
+std::string makeLargeDocument(size_t entryCount)
+{
+  std::string document = "\xEF\xBB\xBF { ";
+  for (size_t i = 0; i != entryCount; ++i) {
+    std::string const key = "key" + std::to_string(i % (entryCount - 10));
+    if (i != 0) {
+      document += ",\n";
+    }
+    if (i % 7 == 0) {
+      document += key + ": { a: \"{,}\", b: { c: \"\\x0022\" } }";
+    } else {
+      document += key + ": \"value, " + std::to_string(i) + " }\"";
+    }
+  }
+  document += " }";
+  return document;
+}
+
+} // namespace
+
 TEST(ParserTests, can_create)
 {
   std::stringstream ss;
@@ -103,3 +184,538 @@ TEST(ParserTests, can_parse_not_empty_nested_section)
   ASSERT_TRUE(result.m_success);
   ASSERT_EQ(expectedTree, result.m_tree);
 }
+
+TEST(ParserTests, can_parse_from_buffer)
+{
+  Parser::ParsedTree const expectedTree = {
+    { "key", "" },
+    { "key:k2", "v1" },
+    { "key:k3", "" },
+    { "x", "5" }
+  };
+  std::string const line = "{ key: { k2: \"v1\", k3: \"\" }, x: \"5\" }";
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_TRUE(result.m_success);
+  ASSERT_EQ(expectedTree, result.m_tree);
+}
+
+TEST(ParserTests, can_not_parse_truncated_buffer)
+{
+  std::string const line = "{ key: { k2: \"v1\" }";
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_FALSE(result.m_success);
+}
+
+TEST(ParserTests, can_parse_file)
+{
+  Parser::ParsedTree const expectedTree = {
+    { "key", "" },
+    { "key:k2", "v1" }
+  };
+  std::string const path = "parser_tests_can_parse_file.txt";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "\xEF\xBB\xBF{ key: { k2: \"v1\" } }";
+  }
+
+  Parser::ParsingResult const result = Parser::parseFile(path);
+  std::remove(path.c_str());
+
+  ASSERT_TRUE(result.m_success);
+  ASSERT_EQ(expectedTree, result.m_tree);
+}
+
+TEST(ParserTests, can_not_parse_missing_file)
+{
+  Parser::ParsingResult const result =
+    Parser::parseFile("parser_tests_missing_file.txt");
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(ParsingErrorKind::InputReadError == result.m_error.m_kind);
+}
+
+#if defined(__unix__)
+TEST(ParserTests, can_read_special_file)
+{
+  Parser::ParsingResult const result = Parser::parseFile("/dev/null");
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(ParsingErrorKind::UnexpectedTokenReceived ==
+    result.m_error.m_kind);
+}
+#endif
+
+TEST(ParserTests, can_parse_from_non_seekable_stream)
+{
+  Parser::ParsedTree const expectedTree = {
+    { "long_key_name", "" },
+    { "long_key_name:k2", u8"v1\n\U0010FFFF" },
+    { "x", "5" }
+  };
+  std::string const line = "\xEF\xBB\xBF"
+    "{ long_key_name: { k2: \"v1\\n\\xDBFF\\xDFFF\" }, x: \"5\" }";
+
+  for (size_t portionSize : { 1, 2, 3, 7 }) {
+    PipeBuffer buffer(line, portionSize);
+    std::istream is(&buffer);
+    Parser parser(is);
+
+    Parser::ParsingResult const result = parser.parse();
+
+    ASSERT_TRUE(result.m_success) << "portion size " << portionSize;
+    ASSERT_EQ(expectedTree, result.m_tree) << "portion size " << portionSize;
+  }
+}
+
+TEST(ParserTests, can_parse_many_entries)
+{
+  Parser::ParsedTree const expectedTree = {
+    { "a", "1" },
+    { "b", "2" },
+    { "c", "" },
+    { "c:d", "3" },
+    { "c:e", "4" },
+    { "c:f", "5" },
+    { "g", "6" }
+  };
+  std::string const line =
+    "{ a: \"1\", b: \"2\", c: { d: \"3\", e: \"4\", f: \"5\" }, g: \"6\" }";
+  std::stringstream ss(line);
+  Parser parser(ss);
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_TRUE(result.m_success);
+  ASSERT_EQ(expectedTree, result.m_tree);
+}
+
+TEST(ParserTests, can_parse_with_handler)
+{
+  std::vector<std::string> const expectedEvents = {
+    "begin ",
+    "entry a=1",
+    "begin b",
+    "entry c=x\ny",
+    "begin d",
+    "end",
+    "end",
+    "entry e=2",
+    "end"
+  };
+  std::string const line =
+    "{ a: \"1\", b: { c: \"x\\ny\", d: { } }, e: \"2\" }";
+  Parser parser(line.data(), line.size());
+  RecordingHandler handler;
+
+  Parser::ParsingResult const result = parser.parse(handler);
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_TRUE(result.m_tree.empty());
+  ASSERT_EQ(expectedEvents, handler.m_events);
+}
+
+TEST(ParserTests, handler_receives_events_before_error)
+{
+  std::vector<std::string> const expectedEvents = {
+    "begin ",
+    "entry a=1"
+  };
+  std::string const line = "{ a: \"1\", b }";
+  std::stringstream ss(line);
+  Parser parser(ss);
+  RecordingHandler handler;
+
+  Parser::ParsingResult const result = parser.parse(handler);
+
+  ASSERT_FALSE(result.m_success);
+  ASSERT_EQ(expectedEvents, handler.m_events);
+}
+
+TEST(ParserTests, can_parse_max_nesting)
+{
+  std::string line;
+  for (size_t i = 1; i != Parser::s_maxSectionDepth; ++i) {
+    line += "{ k: ";
+  }
+  line += "{ k: \"v\" }";
+  line += std::string(Parser::s_maxSectionDepth - 1, '}');
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(Parser::s_maxSectionDepth, result.m_tree.size());
+}
+
+TEST(ParserTests, can_not_parse_too_deep_nesting)
+{
+  std::string line;
+  for (size_t i = 0; i != Parser::s_maxSectionDepth; ++i) {
+    line += "{ k: ";
+  }
+  line += "{ }";
+  line += std::string(Parser::s_maxSectionDepth, '}');
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(ParsingErrorKind::NestingTooDeep == result.m_error.m_kind);
+}
+
+TEST(ParserTests, reports_error_line_and_column)
+{
+  std::string const line = "{\n  a: \"1\",\r\n  b: \"2\"\n  c \"3\"\n}";
+  Parser bufferParser(line.data(), line.size());
+  std::stringstream ss(line);
+  Parser streamParser(ss);
+
+  for (Parser* parser : { &bufferParser, &streamParser }) {
+    Parser::ParsingResult const result = parser->parse();
+
+    ASSERT_FALSE(result.m_success);
+    // after the unexpected key
+    EXPECT_EQ(4u, result.m_error.m_line);
+    EXPECT_EQ(4u, result.m_error.m_column);
+  }
+}
+
+TEST(ParserTests, reports_error_at_line_begin)
+{
+  std::string const line = "{ a: \"1\",\n}";
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_EQ(2u, result.m_error.m_line);
+  EXPECT_EQ(2u, result.m_error.m_column);
+}
+
+TEST(ParserTests, reports_invalid_utf8_position)
+{
+  std::string const line = "{ a: \"1\",\n  b: \"x\xC0\xAF\" }";
+  Parser parser(line.data(), line.size());
+  parser.setUtf8Validation(true);
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_EQ(2u, result.m_error.m_line);
+  EXPECT_EQ(8u, result.m_error.m_column);
+}
+
+TEST(ParserTests, can_parse_in_parallel)
+{
+  std::string const line = makeLargeDocument(50000);
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult const expected = parser.parse();
+  ASSERT_TRUE(expected.m_success);
+
+  for (size_t threadCount : { 0, 1, 2, 3, 8 }) {
+    Parser::ParsingResult const result =
+      Parser::parseParallel(line.data(), line.size(), threadCount);
+
+    ASSERT_TRUE(result.m_success);
+    ASSERT_EQ(expected.m_tree, result.m_tree) << threadCount << " threads";
+  }
+}
+
+TEST(ParserTests, can_parse_small_document_in_parallel)
+{
+  std::string const line = "{ a: \"1\", b: { c: \"2\" } }";
+
+  Parser::ParsingResult const result =
+    Parser::parseParallel(line.data(), line.size(), 4);
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(3u, result.m_tree.size());
+}
+
+TEST(ParserTests, parallel_parsing_reports_error_position)
+{
+  std::string line = makeLargeDocument(50000);
+  size_t const errorPosition = line.size() * 3 / 4;
+  line.insert(line.find(',', errorPosition) + 1, "#");
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult const expected = parser.parse();
+  ASSERT_FALSE(expected.m_success);
+
+  Parser::ParsingResult const result =
+    Parser::parseParallel(line.data(), line.size(), 4);
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(expected.m_error.m_kind == result.m_error.m_kind);
+  EXPECT_EQ(expected.m_error.m_position, result.m_error.m_position);
+  EXPECT_LT(std::streamoff(errorPosition), result.m_error.m_position);
+}
+
+TEST(ParserTests, can_not_parse_trailing_separator_in_parallel)
+{
+  std::string line = makeLargeDocument(50000);
+  line.insert(line.size() - 2, ",");
+
+  Parser::ParsingResult const result =
+    Parser::parseParallel(line.data(), line.size(), 4);
+
+  ASSERT_FALSE(result.m_success);
+}
+
+TEST(ParserTests, can_reset_parser)
+{
+  std::string const first = "{ a: \"1\\n\" }";
+  std::string const second = "{ b: \"2\" }";
+  Parser parser(first.data(), first.size());
+  ASSERT_TRUE(parser.parse().m_success);
+
+  parser.reset(second.data(), second.size());
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_TRUE(result.m_success);
+  ASSERT_EQ(Parser::ParsedTree({ { "b", "2" } }), result.m_tree);
+}
+
+TEST(ParserTests, can_parse_batch)
+{
+  std::vector<std::string> documents;
+  for (size_t i = 0; i != 100; ++i) {
+    std::string document = "{ k" + std::to_string(i) + ": { v: \"" +
+      std::to_string(i) + "\\x0041\" } }";
+    if (i % 10 == 3) {
+      document.insert(document.size() / 2, "#");
+    }
+    documents.push_back(document);
+  }
+  std::vector<TextView> inputs(documents.begin(), documents.end());
+
+  for (size_t threadCount : { 0, 1, 4 }) {
+    std::vector<Parser::ParsingResult> const results =
+      Parser::parseBatch(inputs.data(), inputs.size(), threadCount);
+
+    ASSERT_EQ(documents.size(), results.size());
+    for (size_t i = 0; i != documents.size(); ++i) {
+      Parser parser(documents[i].data(), documents[i].size());
+      Parser::ParsingResult const expected = parser.parse();
+
+      ASSERT_EQ(expected.m_success, results[i].m_success) << i;
+      if (expected.m_success) {
+        EXPECT_EQ(expected.m_tree, results[i].m_tree) << i;
+      } else {
+        EXPECT_EQ(expected.m_error.m_position, results[i].m_error.m_position)
+          << i;
+      }
+    }
+  }
+}
+
+TEST(ParserTests, can_parse_empty_batch)
+{
+  std::vector<Parser::ParsingResult> const results =
+    Parser::parseBatch(nullptr, 0);
+
+  ASSERT_TRUE(results.empty());
+}
+
+TEST(ParserTests, can_push_input_by_portions)
+{
+  std::string const line = "\xEF\xBB\xBF{ a: \"1\", "
+    "bb_b : { c: \"x\\x0041\\n, }\" }, d: { }, e: \"\xD0\xBF\xD1\x80\" }";
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult const expected = parser.parse();
+  ASSERT_TRUE(expected.m_success);
+  PushParser pushParser;
+
+  for (size_t portionSize : { 1, 2, 3, 5, 7, 64 }) {
+    for (size_t position = 0; position < line.size(); position += portionSize)
+    {
+      size_t const size = std::min(portionSize, line.size() - position);
+      ASSERT_TRUE(pushParser.feed(line.data() + position, size));
+    }
+    EXPECT_TRUE(pushParser.isComplete());
+
+    Parser::ParsingResult const result = pushParser.finish();
+
+    ASSERT_TRUE(result.m_success) << portionSize;
+    ASSERT_EQ(expected.m_tree, result.m_tree) << portionSize;
+  }
+}
+
+TEST(ParserTests, push_parser_reports_events_before_input_end)
+{
+  std::vector<std::string> const expectedEvents = {
+    "begin ",
+    "entry a=1",
+    "begin b"
+  };
+  std::string const line = "{ a: \"1\", b: { c: \"2";
+  RecordingHandler handler;
+  PushParser parser(handler);
+
+  ASSERT_TRUE(parser.feed(line.data(), line.size()));
+
+  EXPECT_FALSE(parser.isComplete());
+  ASSERT_EQ(expectedEvents, handler.m_events);
+}
+
+TEST(ParserTests, push_parser_reports_error_position)
+{
+  for (std::string const line : {
+    "{ a: \"1\", b: { c: \"2\" }",
+    "{ a: \"1\", b: # }",
+    "{ a: \"1\" b: \"2\" }",
+    "{\n  a: \"1\",\n  b: \"2\"\n  c: \"3\"\n}"
+  }) {
+    Parser parser(line.data(), line.size());
+    Parser::ParsingResult const expected = parser.parse();
+    ASSERT_FALSE(expected.m_success);
+    PushParser pushParser;
+
+    for (char c : line) {
+      pushParser.feed(&c, 1);
+    }
+    Parser::ParsingResult const result = pushParser.finish();
+
+    ASSERT_FALSE(result.m_success) << line;
+    EXPECT_TRUE(expected.m_error.m_kind == result.m_error.m_kind) << line;
+    EXPECT_EQ(expected.m_error.m_position, result.m_error.m_position)
+      << line;
+    EXPECT_EQ(expected.m_error.m_line, result.m_error.m_line) << line;
+    EXPECT_EQ(expected.m_error.m_column, result.m_error.m_column) << line;
+  }
+}
+
+#if defined(PARSER_WITH_PMR)
+TEST(ParserTests, can_parse_into_memory_resource)
+{
+  std::string const line =
+    "{ key: { k2: \"v1\", k3: \"a long value out of SSO\" } }";
+  Parser parser(line.data(), line.size());
+  std::pmr::monotonic_buffer_resource resource;
+
+  Parser::PmrParsingResult const result = parser.parse(&resource);
+
+  ASSERT_TRUE(result.m_success);
+  ASSERT_EQ(3u, result.m_tree.size());
+  EXPECT_EQ(&resource, result.m_tree.get_allocator().resource());
+  auto const iEntry = result.m_tree.find("key:k3");
+  ASSERT_NE(result.m_tree.end(), iEntry);
+  EXPECT_EQ("a long value out of SSO", iEntry->second);
+  EXPECT_EQ(&resource, iEntry->second.get_allocator().resource());
+}
+#endif
+
+#if defined(PARSER_WITH_STATS)
+TEST(ParserTests, can_collect_parsing_stats)
+{
+  std::string const line =
+    "{ key: { k2: \"v1\", k3: \"a long value out of SSO\" }, k4: \"v2\" }";
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_TRUE(result.m_success);
+  ParsingStats const& stats = result.m_stats;
+  EXPECT_EQ(line.size(), stats.m_bytes);
+  EXPECT_EQ(4u, stats.m_tokenCounts[size_t(TokenKind::Key)]);
+  EXPECT_EQ(3u, stats.m_tokenCounts[size_t(TokenKind::Value)]);
+  EXPECT_EQ(2u, stats.m_tokenCounts[size_t(TokenKind::SectionBegin)]);
+  EXPECT_EQ(2u, stats.m_tokenCounts[size_t(TokenKind::EntrySeparator)]);
+  EXPECT_EQ(0u, stats.m_tokenCounts[size_t(TokenKind::ParseEnd)]);
+  EXPECT_EQ(2u, stats.m_maxDepth);
+  EXPECT_LE(stats.m_lexingTime + stats.m_handlingTime, stats.m_totalTime);
+}
+
+TEST(ParserTests, stats_count_failed_token)
+{
+  std::string const line = "{ key: \"v1\" ; }";
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_EQ(1u, result.m_stats.m_tokenCounts[size_t(TokenKind::ParseError)]);
+}
+
+TEST(ParserTests, parallel_stats_match_serial_ones)
+{
+  // The last keys repeat the first ones, which are in other chunks
+  std::string const line = makeLargeDocument(50000) + "\n";
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult const expected = parser.parse();
+  ASSERT_TRUE(expected.m_success);
+
+  Parser::ParsingResult const result =
+    Parser::parseParallel(line.data(), line.size(), 4);
+
+  ASSERT_TRUE(result.m_success);
+  ParsingStats const& stats = result.m_stats;
+  EXPECT_EQ(expected.m_stats.m_bytes, stats.m_bytes);
+  EXPECT_EQ(expected.m_stats.m_tokenCounts, stats.m_tokenCounts);
+  EXPECT_EQ(expected.m_stats.m_maxDepth, stats.m_maxDepth);
+  EXPECT_EQ(stats.m_totalTime,
+    stats.m_lexingTime + stats.m_parsingTime + stats.m_handlingTime);
+  EXPECT_LE(ParsingStats::Duration::zero(), stats.m_parsingTime);
+}
+#endif // PARSER_WITH_STATS
+
+TEST(ParserTests, can_not_parse_failed_stream)
+{
+  std::stringstream ss("{ a: \"1\" }");
+  ss.setstate(std::ios::badbit);
+  Lexer lexer(ss);
+  Parser parser(ss);
+
+  EXPECT_EQ(TokenKind::ParseError, lexer.getCurrent());
+  EXPECT_TRUE(LexingErrorKind::InputReadError == lexer.getErrorKind());
+
+  Parser::ParsingResult const result = parser.parse();
+
+  ASSERT_FALSE(result.m_success);
+  EXPECT_TRUE(ParsingErrorKind::InputReadError == result.m_error.m_kind);
+}
+
+namespace {
+
+// Gives the text and then fails to read more
+class FailingBuffer : public std::streambuf {
+public:
+  explicit FailingBuffer(std::string text)
+    : m_text(std::move(text))
+  {
+    setg(&m_text[0], &m_text[0], &m_text[0] + m_text.size());
+  }
+
+protected:
+  int_type underflow() override
+  {
+    throw std::runtime_error("read error");
+  }
+
+private:
+  std::string m_text;
+};
+
+} // namespace
+
+TEST(ParserTests, reports_stream_failure_while_reading)
+{
+  // The failure ends the input between tokens and within a value
+  for (std::string const text : { "{ a: \"1\", ", "{ a: \"1\", b: \"va" }) {
+    FailingBuffer buffer(text);
+    std::istream is(&buffer);
+    Parser parser(is);
+
+    Parser::ParsingResult const result = parser.parse();
+
+    ASSERT_FALSE(result.m_success) << text;
+    EXPECT_TRUE(ParsingErrorKind::InputReadError == result.m_error.m_kind)
+      << text;
+    EXPECT_TRUE(is.bad()) << text;
+  }
+}
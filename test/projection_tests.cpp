@@ -0,0 +1,219 @@
+#include "gtest/gtest.h"
+
+#include "projection.hxx"
+
+#include <string>
+#include <vector>
+
+
+using namespace parsing;
+
+namespace {
+
+Parser::ParsingResult parseProjection(std::string const& line,
+  Projection const& projection)
+{
+  return Parser::parseProjection(line.data(), line.size(), projection);
+}
+
+// Parses the whole line and keeps the selected entries
+Parser::ParsedTree parseSelected(std::string const& line,
+  Projection const& projection)
+{
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult result = parser.parse();
+  EXPECT_TRUE(result.m_success) << line;
+
+  Parser::ParsedTree tree;
+  for (auto const& entry : result.m_tree) {
+    if (projection.selects(entry.first)) {
+      tree.insert(entry);
+    }
+  }
+  return tree;
+}
+
+std::string repeat(std::string const& text, size_t count)
+{
+  std::string result;
+  for (size_t i = 0; i != count; ++i) {
+    result += text;
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(ProjectionTests, can_select_keys)
+{
+  Projection const projection = { "a:b", "c", "d:e:f" };
+
+  EXPECT_EQ(3u, projection.getPathCount());
+  EXPECT_TRUE(projection.selects("a:b"));
+  EXPECT_TRUE(projection.selects("a:b:x"));
+  EXPECT_TRUE(projection.selects("c"));
+  EXPECT_TRUE(projection.selects("c:x:y"));
+  EXPECT_TRUE(projection.selects("d:e:f"));
+  EXPECT_FALSE(projection.selects("a"));
+  EXPECT_FALSE(projection.selects("a:bb"));
+  EXPECT_FALSE(projection.selects("a:c"));
+  EXPECT_FALSE(projection.selects("c0"));
+  EXPECT_FALSE(projection.selects("d:e"));
+  EXPECT_FALSE(projection.selects(""));
+}
+
+TEST(ProjectionTests, empty_path_selects_everything)
+{
+  Projection projection;
+  EXPECT_FALSE(projection.selects("a"));
+
+  projection.add("");
+
+  EXPECT_TRUE(projection.selects("a"));
+  EXPECT_TRUE(projection.selects("a:b"));
+}
+
+TEST(ProjectionTests, can_parse_selected_entries)
+{
+  std::string const line =
+    "{ a: { b: \"1\", c: \"2\", b0: \"x\" }, c: { x: { y: \"3\" } },"
+    " d: { e: { f: \"4\", g: \"5\" }, f: \"6\" }, e: \"7\" }";
+  Projection const projection = { "a:b", "c", "d:e:f", "e:x" };
+
+  Parser::ParsingResult const result = parseProjection(line, projection);
+
+  ASSERT_TRUE(result.m_success);
+  Parser::ParsedTree const expected = {
+    { "a:b", "1" }, { "c", "" }, { "c:x", "" }, { "c:x:y", "3" },
+    { "d:e:f", "4" }
+  };
+  EXPECT_EQ(expected, result.m_tree);
+  EXPECT_EQ(parseSelected(line, projection), result.m_tree);
+}
+
+TEST(ProjectionTests, selects_same_entries_as_parse)
+{
+  // Sections span the blocks of the skipping
+  std::string line = "{";
+  for (int i = 0; i != 200; ++i) {
+    line += "k" + std::to_string(i) + ": { v: \"value\\x0022\\n" +
+      std::to_string(i) + "\", s: { e: {}, t: \"}{\" } },\n";
+  }
+  line += "last: \"\" }";
+  Projection const projection = {
+    "k3", "k17:v", "k50:s:e", "k99:s:t", "k150:x", "k199:s", "missing"
+  };
+
+  Parser::ParsingResult const result = parseProjection(line, projection);
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(11u, result.m_tree.size());
+  EXPECT_EQ(parseSelected(line, projection), result.m_tree);
+}
+
+TEST(ProjectionTests, skips_braces_and_escapes_in_values)
+{
+  std::string const line =
+    "{ x: \"}{\\x0022\\q\", y: { z: \"}\", w: { v: \"{{\" } },"
+    " k: \"\\x0041\\n\" }";
+
+  Parser::ParsingResult const result = parseProjection(line, { "k" });
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(Parser::ParsedTree({ { "k", "A\n" } }), result.m_tree);
+}
+
+TEST(ProjectionTests, can_parse_whole_document)
+{
+  std::string const line = "{ a: { b: \"1\" }, c: \"2\" }";
+  Parser parser(line.data(), line.size());
+
+  Parser::ParsingResult const result = parseProjection(line, { "" });
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(parser.parse().m_tree, result.m_tree);
+}
+
+TEST(ProjectionTests, keeps_first_duplicate)
+{
+  std::string const line =
+    "{ a: { b: \"1\" }, a: { b: \"2\", c: \"3\" }, d: \"4\", d: \"5\" }";
+
+  Parser::ParsingResult const result =
+    parseProjection(line, { "a:b", "a:c", "d" });
+
+  ASSERT_TRUE(result.m_success);
+  Parser::ParsedTree const expected = {
+    { "a:b", "1" }, { "a:c", "3" }, { "d", "4" }
+  };
+  EXPECT_EQ(expected, result.m_tree);
+  EXPECT_EQ(parseSelected(line, { "a:b", "a:c", "d" }), result.m_tree);
+}
+
+TEST(ProjectionTests, parses_path_through_value_as_nothing)
+{
+  std::string const line = "{ a: \"1\", b: { } }";
+
+  Parser::ParsingResult const result =
+    parseProjection(line, { "a:x", "b:y" });
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_TRUE(result.m_tree.empty());
+}
+
+TEST(ProjectionTests, does_not_find_errors_in_skipped_entries)
+{
+  std::string const line = "{ a: \"\\q\", b: { c: d }, e: \"1\" }";
+
+  Parser::ParsingResult const result = parseProjection(line, { "e" });
+
+  ASSERT_TRUE(result.m_success);
+  EXPECT_EQ(Parser::ParsedTree({ { "e", "1" } }), result.m_tree);
+}
+
+TEST(ProjectionTests, reports_errors_as_parse)
+{
+  std::vector<std::string> const lines = {
+    "{ a: \"1\", e: \"\\q\" }",
+    "{ a: \"1\", e: { f: \"1\" g: \"2\" } }",
+    "{ a: { b: \"1\" }",
+    "{ a: \"1\" e: \"2\" }",
+    "{ a: \"1",
+    "a: \"1\""
+  };
+
+  for (std::string const& line : lines) {
+    Parser parser(line.data(), line.size());
+    Parser::ParsingResult const expected = parser.parse();
+
+    Parser::ParsingResult const result = parseProjection(line, { "e" });
+
+    ASSERT_FALSE(result.m_success) << line;
+    EXPECT_TRUE(expected.m_error.m_kind == result.m_error.m_kind) << line;
+    EXPECT_EQ(expected.m_error.m_position, result.m_error.m_position)
+      << line;
+  }
+}
+
+TEST(ProjectionTests, checks_nesting_of_selected_entries)
+{
+  // Sections nested in the root one up to the limit and past it
+  size_t const depth = Parser::s_maxSectionDepth - 1;
+  std::string const valid =
+    "{" + repeat(" a: {", depth) + repeat(" }", depth) + " }";
+  std::string const deep =
+    "{" + repeat(" a: {", depth + 1) + repeat(" }", depth + 1) + " }";
+  std::string path = "a";
+  for (size_t section = 1; section != depth; ++section) {
+    path += ":a";
+  }
+
+  for (TextView selected : { TextView("a"), TextView(path) }) {
+    EXPECT_TRUE(parseProjection(valid, { selected }).m_success);
+
+    Parser::ParsingResult const result =
+      parseProjection(deep, { selected });
+    ASSERT_FALSE(result.m_success);
+    EXPECT_TRUE(ParsingErrorKind::NestingTooDeep == result.m_error.m_kind);
+  }
+}
@@ -0,0 +1,298 @@
+#include "gtest/gtest.h"
+
+#include "scanning.hxx"
+
+#include <string>
+#include <vector>
+
+
+using namespace parsing;
+
+namespace {
+
+using ScanFunction = char const* (*)(char const*, char const*);
+
+std::vector<ScanFunction> getSkipIgnoredKernels()
+{
+  std::vector<ScanFunction> kernels = { scanning::scalar::skipIgnored };
+#if PARSING_HAS_SSE2
+  kernels.push_back(scanning::sse2::skipIgnored);
+#endif
+#if PARSING_HAS_AVX2
+  if (scanning::isAvx2Supported()) {
+    kernels.push_back(scanning::avx2::skipIgnored);
+  }
+#endif
+  return kernels;
+}
+
+std::vector<ScanFunction> getFindValueSpecialKernels()
+{
+  std::vector<ScanFunction> kernels = { scanning::scalar::findValueSpecial };
+#if PARSING_HAS_SSE2
+  kernels.push_back(scanning::sse2::findValueSpecial);
+#endif
+#if PARSING_HAS_AVX2
+  if (scanning::isAvx2Supported()) {
+    kernels.push_back(scanning::avx2::findValueSpecial);
+  }
+#endif
+  return kernels;
+}
+
+std::vector<ScanFunction> getFindStructuralKernels()
+{
+  std::vector<ScanFunction> kernels = { scanning::scalar::findStructural };
+#if PARSING_HAS_SSE2
+  kernels.push_back(scanning::sse2::findStructural);
+#endif
+#if PARSING_HAS_AVX2
+  if (scanning::isAvx2Supported()) {
+    kernels.push_back(scanning::avx2::findStructural);
+  }
+#endif
+  return kernels;
+}
+
+std::vector<ScanFunction> getFindInvalidUtf8Kernels()
+{
+  std::vector<ScanFunction> kernels = { scanning::scalar::findInvalidUtf8 };
+#if PARSING_HAS_SSE2
+  kernels.push_back(scanning::sse2::findInvalidUtf8);
+#endif
+#if PARSING_HAS_AVX2
+  if (scanning::isAvx2Supported()) {
+    kernels.push_back(scanning::avx2::findInvalidUtf8);
+  }
+#endif
+  return kernels;
+}
+
+std::vector<ScanFunction> getSkipSectionKernels()
+{
+  std::vector<ScanFunction> kernels = { scanning::scalar::skipSection };
+#if PARSING_HAS_SSE2
+  kernels.push_back(scanning::sse2::skipSection);
+#endif
+#if PARSING_HAS_AVX2
+  if (scanning::isAvx2Supported()) {
+    kernels.push_back(scanning::avx2::skipSection);
+  }
+#endif
+  return kernels;
+}
+
+} // namespace
+
+TEST(ScanningTests, skip_ignored_stops_at_every_byte_at_every_position)
+{
+  for (int byte = 0; byte != 256; ++byte) {
+    char const c = static_cast<char>(byte);
+    for (size_t position : { 0, 1, 15, 16, 17, 31, 32, 33, 70 }) {
+      std::string const line = std::string(position, ' ') + c + "   ";
+      size_t const expected = scanning::isIgnored(c) ?
+        line.size() : position;
+
+      for (auto kernel : getSkipIgnoredKernels()) {
+        char const* const result =
+          kernel(line.data(), line.data() + line.size());
+        ASSERT_EQ(expected, size_t(result - line.data()))
+          << "byte " << byte << ", position " << position;
+      }
+    }
+  }
+}
+
+TEST(ScanningTests, find_value_special_stops_at_every_byte_at_every_position)
+{
+  for (int byte = 0; byte != 256; ++byte) {
+    char const c = static_cast<char>(byte);
+    for (size_t position : { 0, 1, 15, 16, 17, 31, 32, 33, 70 }) {
+      std::string const line = std::string(position, 'a') + c + "aaa";
+      size_t const expected = scanning::isValueSpecial(c) ?
+        position : line.size();
+
+      for (auto kernel : getFindValueSpecialKernels()) {
+        char const* const result =
+          kernel(line.data(), line.data() + line.size());
+        ASSERT_EQ(expected, size_t(result - line.data()))
+          << "byte " << byte << ", position " << position;
+      }
+    }
+  }
+}
+
+TEST(ScanningTests, find_structural_stops_at_every_byte_at_every_position)
+{
+  for (int byte = 0; byte != 256; ++byte) {
+    char const c = static_cast<char>(byte);
+    for (size_t position : { 0, 1, 15, 16, 17, 31, 32, 33, 70 }) {
+      std::string const line = std::string(position, 'a') + c + "aaa";
+      size_t const expected = scanning::isStructural(c) ?
+        position : line.size();
+
+      for (auto kernel : getFindStructuralKernels()) {
+        char const* const result =
+          kernel(line.data(), line.data() + line.size());
+        ASSERT_EQ(expected, size_t(result - line.data()))
+          << "byte " << byte << ", position " << position;
+      }
+    }
+  }
+}
+
+TEST(ScanningTests, find_invalid_utf8_at_every_position)
+{
+  std::vector<std::string> const valid = {
+    "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF",
+    "\xEE\x80\x80", "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF"
+  };
+  std::vector<std::string> const invalid = {
+    "\x80", "\xBF", "\xC0\xAF", "\xC1\xBF", "\xE0\x9F\xBF",
+    "\xED\xA0\x80", "\xF0\x8F\xBF\xBF", "\xF4\x90\x80\x80",
+    "\xF5\x80\x80\x80", "\xFF", "\xC2", "\xE4\xB8", "\xC2\x41",
+    "\xF0\x9F\x98"
+  };
+
+  for (size_t position : { 0, 1, 15, 16, 17, 31, 32, 33, 70 }) {
+    for (std::string const& sequence : valid) {
+      std::string const line =
+        std::string(position, 'a') + sequence + "\xD0\x96" "a";
+      for (auto kernel : getFindInvalidUtf8Kernels()) {
+        char const* const result =
+          kernel(line.data(), line.data() + line.size());
+        ASSERT_EQ(line.size(), size_t(result - line.data()))
+          << "valid sequence at position " << position;
+      }
+    }
+
+    for (std::string const& sequence : invalid) {
+      // The sequence is either followed by ASCII or ends the text
+      for (std::string const& tail : { std::string("aaa"), std::string() }) {
+        std::string const line =
+          std::string(position, 'a') + "\xD0\x96" + sequence + tail;
+        for (auto kernel : getFindInvalidUtf8Kernels()) {
+          char const* const result =
+            kernel(line.data(), line.data() + line.size());
+          ASSERT_EQ(position + 2, size_t(result - line.data()))
+            << "invalid sequence at position " << position;
+        }
+      }
+    }
+  }
+}
+
+TEST(ScanningTests, skip_section_finds_section_end_at_every_position)
+{
+  std::vector<std::string> const bodies = {
+    "", "a: \"v\"", "a: { b: {} }", "a: \"}\"", "a: \"{\", b: \"}{\"",
+    "a: { b: \"x}\" }, c: {{}}",
+    std::string(40, '{') + "\"}}\"" + std::string(40, '}')
+  };
+
+  for (size_t position : { 0, 1, 15, 16, 17, 31, 32, 33, 70 }) {
+    for (std::string const& body : bodies) {
+      // Values and sections cross the block bounds
+      std::string const line =
+        std::string(position, ' ') + body + "} b: \"}\" }";
+      size_t const expected = position + body.size();
+
+      for (auto kernel : getSkipSectionKernels()) {
+        char const* const result =
+          kernel(line.data(), line.data() + line.size());
+        ASSERT_EQ(expected, size_t(result - line.data()))
+          << "body " << body << ", position " << position;
+      }
+    }
+  }
+}
+
+TEST(ScanningTests, skip_section_returns_end_of_unclosed_section)
+{
+  std::vector<std::string> const bodies = {
+    "", "a: \"}", "a: {}", "a: { b: \"}\" }", std::string(100, '{') + "}"
+  };
+
+  for (std::string const& body : bodies) {
+    std::string const line = body + std::string(40, ' ');
+    for (auto kernel : getSkipSectionKernels()) {
+      char const* const result =
+        kernel(line.data(), line.data() + line.size());
+      EXPECT_EQ(line.size(), size_t(result - line.data())) << body;
+    }
+  }
+}
+
+TEST(ScanningTests, can_decode_escape_runs)
+{
+  std::string const text =
+    "\\n\\r\\\\\\x0041\\x00e9\\x4E2D\\xd83d\\xDE00" "tail";
+  std::string output(text.size(), '\0');
+  scanning::DecodedEscapes const decoded = scanning::decodeEscapes(
+    text.data(), text.data() + text.size(), &output[0]);
+
+  EXPECT_EQ(text.size() - 4, size_t(decoded.m_input - text.data()));
+  output.resize(size_t(decoded.m_output - output.data()));
+  EXPECT_EQ("\n\r\\A\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80", output);
+}
+
+TEST(ScanningTests, decode_escapes_stops_at_wrong_sequences)
+{
+  std::vector<std::string> const wrong = {
+    "\\", "\\q", "\\x", "\\x004", "\\x00g1", "\\x/000", "\\x:000",
+    "\\x@000", "\\xG000", "\\x`000", "\\x\xC1" "000", "\\xd83d",
+    "\\xd83d\\n", "\\xd83d\\x0041", "\\xd83d\\xde0"
+  };
+
+  for (std::string const& sequence : wrong) {
+    std::string const text = "\\n" + sequence;
+    std::string output(text.size(), '\0');
+    scanning::DecodedEscapes const decoded = scanning::decodeEscapes(
+      text.data(), text.data() + text.size(), &output[0]);
+
+    EXPECT_EQ(2, decoded.m_input - text.data()) << sequence;
+    EXPECT_EQ(1, decoded.m_output - output.data()) << sequence;
+  }
+}
+
+TEST(ScanningTests, decode_escapes_reads_every_hex_digit)
+{
+  for (int position = 0; position != 4; ++position) {
+    for (int c = 0; c != 256; ++c) {
+      std::string text = "\\x0000";
+      text[2 + position] = char(c);
+      std::string output(text.size(), '\0');
+      scanning::DecodedEscapes const decoded = scanning::decodeEscapes(
+        text.data(), text.data() + text.size(), &output[0]);
+
+      int digit = -1;
+      if (('0' <= c) && (c <= '9')) {
+        digit = c - '0';
+      } else if (('a' <= c) && (c <= 'f')) {
+        digit = c - 'a' + 10;
+      } else if (('A' <= c) && (c <= 'F')) {
+        digit = c - 'A' + 10;
+      }
+      if (digit < 0) {
+        EXPECT_EQ(text.data(), decoded.m_input) << c;
+        continue;
+      }
+
+      int const codepoint = digit << (4 * (3 - position));
+      std::string expected;
+      if (codepoint < 0x80) {
+        expected = { char(codepoint) };
+      } else if (codepoint < 0x800) {
+        expected = { char(0xC0 | (codepoint >> 6)),
+          char(0x80 | (codepoint & 0x3F)) };
+      } else {
+        expected = { char(0xE0 | (codepoint >> 12)),
+          char(0x80 | ((codepoint >> 6) & 0x3F)),
+          char(0x80 | (codepoint & 0x3F)) };
+      }
+      EXPECT_EQ(text.data() + text.size(), decoded.m_input) << c;
+      output.resize(size_t(decoded.m_output - output.data()));
+      EXPECT_EQ(expected, output) << c;
+    }
+  }
+}
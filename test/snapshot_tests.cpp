@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+
+#include "snapshot.hxx"
+
+#include <cstdio>
+#include <string>
+
+
+using namespace parsing;
+
+namespace {
+
+Parser::ParsedTree parse(std::string const& line)
+{
+  Parser parser(line.data(), line.size());
+  return parser.parse().m_tree;
+}
+
+} // namespace
+
+TEST(SnapshotTests, can_create)
+{
+  Snapshot snapshot;
+
+  EXPECT_FALSE(snapshot.isOpen());
+  EXPECT_EQ(0u, snapshot.getEntryCount());
+}
+
+TEST(SnapshotTests, can_find_entries)
+{
+  std::string const line =
+    "{ b: \"1\", a: { y: \"x\\ny\", x: { } }, c: \"\\x0444\" }";
+  Parser::ParsedTree const tree = parse(line);
+  std::string const image = Snapshot::serialize(tree, 42);
+  Snapshot snapshot;
+
+  ASSERT_TRUE(snapshot.open(image.data(), image.size()));
+
+  EXPECT_EQ(42u, snapshot.getSourceHash());
+  ASSERT_EQ(tree.size(), snapshot.getEntryCount());
+  size_t index = 0;
+  for (auto const& entry : tree) {
+    EXPECT_EQ(entry.first, snapshot.getKey(index));
+    EXPECT_EQ(entry.second, snapshot.getValue(index));
+
+    TextView value;
+    ASSERT_TRUE(snapshot.find(entry.first, value));
+    EXPECT_EQ(entry.second, value);
+    ++index;
+  }
+
+  TextView value;
+  EXPECT_FALSE(snapshot.find("a:z", value));
+  EXPECT_FALSE(snapshot.find("", value));
+  EXPECT_FALSE(snapshot.find("d", value));
+}
+
+TEST(SnapshotTests, can_open_empty_tree)
+{
+  std::string const image = Snapshot::serialize(Parser::ParsedTree(), 0);
+  Snapshot snapshot;
+
+  ASSERT_TRUE(snapshot.open(image.data(), image.size()));
+
+  EXPECT_EQ(0u, snapshot.getEntryCount());
+  TextView value;
+  EXPECT_FALSE(snapshot.find("a", value));
+}
+
+TEST(SnapshotTests, can_not_open_damaged_image)
+{
+  std::string const image =
+    Snapshot::serialize(parse("{ a: \"1\", b: \"2\" }"), 0);
+  Snapshot snapshot;
+
+  for (size_t position : { size_t(0), image.size() / 2, image.size() - 1 }) {
+    std::string damaged = image;
+    damaged[position] ^= 1;
+    EXPECT_FALSE(snapshot.open(damaged.data(), damaged.size())) << position;
+  }
+
+  std::string const truncated = image.substr(0, image.size() - 1);
+  EXPECT_FALSE(snapshot.open(truncated.data(), truncated.size()));
+  EXPECT_FALSE(snapshot.isOpen());
+}
+
+TEST(SnapshotTests, can_open_file)
+{
+  std::string const line = "{ key: { k2: \"v1\" } }";
+  std::string const changedLine = "{ key: { k2: \"v2\" } }";
+  std::string const path = "snapshot_tests_can_open_file.bin";
+  ASSERT_TRUE(Snapshot::writeFile(path, parse(line),
+    Snapshot::hashSource(line.data(), line.size())));
+  Snapshot snapshot;
+
+  bool const isOpen = snapshot.open(path);
+  std::remove(path.c_str());
+
+  ASSERT_TRUE(isOpen);
+  EXPECT_TRUE(snapshot.isMadeFrom(line.data(), line.size()));
+  EXPECT_FALSE(snapshot.isMadeFrom(changedLine.data(), changedLine.size()));
+  TextView value;
+  ASSERT_TRUE(snapshot.find("key:k2", value));
+  EXPECT_EQ(std::string("v1"), value);
+}
+
+TEST(SnapshotTests, can_not_open_missing_file)
+{
+  Snapshot snapshot;
+
+  EXPECT_FALSE(snapshot.open("snapshot_tests_missing_file.bin"));
+}
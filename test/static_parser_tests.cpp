@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+
+#include "static_parser.hxx"
+
+#include <stdexcept>
+#include <string>
+
+
+using namespace parsing;
+using namespace parsing::static_parsing;
+
+namespace {
+
+constexpr auto s_tree = PARSING_STATIC_TREE(
+  "\xEF\xBB\xBF{ b: \"1\", a: { y: \"x\\ny\", x: { } }, "
+  "c: \"\\x0444\\xD83D\\xDE00\", b: \"2\" }");
+
+constexpr StaticText findValue(StaticText key)
+{
+  StaticText value;
+  if (!s_tree.find(key, value)) {
+    throw std::invalid_argument("Key is not found");
+  }
+  return value;
+}
+
+static_assert(s_tree.getSize() == 5, "unexpected size");
+static_assert(s_tree.getKey(0) == "a", "unexpected key");
+static_assert(s_tree.getKey(1) == "a:x", "unexpected key");
+static_assert(findValue("b") == "1", "the first key must win");
+static_assert(findValue("a:y") == "x\ny", "escapes must be decoded");
+
+std::string toString(StaticText text)
+{
+  return std::string(text.getData(), text.getSize());
+}
+
+} // namespace
+
+TEST(StaticParserTests, can_parse_at_compile_time)
+{
+  std::string const line = "\xEF\xBB\xBF{ b: \"1\", a: { y: \"x\\ny\", "
+    "x: { } }, c: \"\\x0444\\xD83D\\xDE00\", b: \"2\" }";
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult const expected = parser.parse();
+  ASSERT_TRUE(expected.m_success);
+
+  ASSERT_EQ(expected.m_tree.size(), s_tree.getSize());
+  size_t index = 0;
+  for (auto const& entry : expected.m_tree) {
+    EXPECT_EQ(entry.first, toString(s_tree.getKey(index)));
+    EXPECT_EQ(entry.second, toString(s_tree.getValue(index)));
+    ++index;
+  }
+}
+
+TEST(StaticParserTests, can_parse_empty_section)
+{
+  constexpr auto tree = PARSING_STATIC_TREE("{ }");
+
+  StaticText value;
+  EXPECT_EQ(0u, tree.getSize());
+  EXPECT_FALSE(tree.find("a", value));
+}
+
+TEST(StaticParserTests, can_not_parse_malformed_input)
+{
+  for (std::string const line : {
+    "",
+    "{",
+    "{ a }",
+    "{ a: \"1\", }",
+    "{ a: \"1\" b: \"2\" }",
+    "{ a: \"1\\q\" }",
+    "{ a: \"\\xD83D\" }",
+    "{ a: \"1\n\" }",
+    "\xEF\xBB{ }"
+  }) {
+    Parser parser(line.data(), line.size());
+    ASSERT_FALSE(parser.parse().m_success) << line;
+
+    EXPECT_THROW(measure(StaticText(line.data(), line.size())),
+      std::invalid_argument) << line;
+  }
+}
@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+
+#include "writer.hxx"
+
+#include <cstdio>
+#include <string>
+
+
+using namespace parsing;
+
+namespace {
+
+Parser::ParsedTree parse(std::string const& line)
+{
+  Parser parser(line.data(), line.size());
+  Parser::ParsingResult result = parser.parse();
+  EXPECT_TRUE(result.m_success) << line;
+  return std::move(result.m_tree);
+}
+
+std::string write(Parser::ParsedTree const& tree, WritingStyle style)
+{
+  std::string output;
+  Writer(style).write(tree, output);
+  return output;
+}
+
+} // namespace
+
+TEST(WriterTests, can_write_compact)
+{
+  Parser::ParsedTree const tree =
+    parse("{ b: \"1\", a: { y: \"x\\ny\", x: { } }, c: \"\\x0444\" }");
+
+  EXPECT_EQ("{a:{x:\"\",y:\"x\\ny\"},b:\"1\",c:\"\xD1\x84\"}",
+    write(tree, WritingStyle::Compact));
+}
+
+TEST(WriterTests, can_write_pretty)
+{
+  Parser::ParsedTree const tree =
+    parse("{ b: \"1\", a: { y: \"x\\ny\", x: { } }, c: \"\\x0444\" }");
+
+  EXPECT_EQ(
+    "{\n"
+    "  a: {\n"
+    "    x: \"\",\n"
+    "    y: \"x\\ny\"\n"
+    "  },\n"
+    "  b: \"1\",\n"
+    "  c: \"\xD1\x84\"\n"
+    "}\n",
+    write(tree, WritingStyle::Pretty));
+}
+
+TEST(WriterTests, can_write_empty_tree)
+{
+  EXPECT_EQ("{}", write(Parser::ParsedTree(), WritingStyle::Compact));
+  EXPECT_EQ("{}\n", write(Parser::ParsedTree(), WritingStyle::Pretty));
+}
+
+TEST(WriterTests, can_escape_values)
+{
+  Parser::ParsedTree const tree = {
+    { "a", std::string("q\"\\\n\r\t\x7F\x01" "end\xD0\x96", 13) }
+  };
+
+  std::string const output = write(tree, WritingStyle::Compact);
+
+  EXPECT_EQ("{a:\"q\\x0022\\\\\\n\\r\\x0009\\x007f\\x0001end\xD0\x96\"}",
+    output);
+  EXPECT_EQ(tree, parse(output));
+}
+
+TEST(WriterTests, can_write_sections_without_entries)
+{
+  Parser::ParsedTree const tree = {
+    { "a:b", "1" }, { "a:c:d", "2" }, { "a0", "x" }
+  };
+
+  EXPECT_EQ("{a0:\"x\",a:{b:\"1\",c:{d:\"2\"}}}",
+    write(tree, WritingStyle::Compact));
+}
+
+TEST(WriterTests, writes_entries_with_children_as_sections)
+{
+  Parser::ParsedTree const tree = {
+    { "a", "dropped" }, { "a0", "x" }, { "a:b", "1" }
+  };
+
+  EXPECT_EQ("{a:{b:\"1\"},a0:\"x\"}", write(tree, WritingStyle::Compact));
+}
+
+TEST(WriterTests, can_write_children_ordered_after_other_keys)
+{
+  Parser::ParsedTree const tree = {
+    { "a", "" }, { "a0", "" }, { "a00", "y" }, { "a0:c", "2" },
+    { "a:b", "1" }, { "a:b0", "3" }
+  };
+
+  std::string const output = write(tree, WritingStyle::Compact);
+
+  EXPECT_EQ("{a:{b:\"1\",b0:\"3\"},a0:{c:\"2\"},a00:\"y\"}", output);
+  EXPECT_EQ(tree, parse(output));
+}
+
+TEST(WriterTests, appends_to_output)
+{
+  std::string output = "prefix";
+
+  Writer(WritingStyle::Compact).write({ { "a", "1" } }, output);
+
+  EXPECT_EQ("prefix{a:\"1\"}", output);
+}
+
+TEST(WriterTests, written_document_parses_to_same_tree)
+{
+  std::string line = "{";
+  for (int i = 0; i != 100; ++i) {
+    line += "k" + std::to_string(i) + ": { v: \"value\\x0022\\n" +
+      std::to_string(i) + "\", s: { e: {} } },";
+  }
+  line += "last: \"\" }";
+  Parser::ParsedTree const tree = parse(line);
+
+  EXPECT_EQ(tree, parse(write(tree, WritingStyle::Compact)));
+  EXPECT_EQ(tree, parse(write(tree, WritingStyle::Pretty)));
+}
+
+TEST(WriterTests, can_write_to_file_descriptor)
+{
+  // Many blocks and a value larger than a block
+  Parser::ParsedTree tree;
+  for (int i = 0; i != 10000; ++i) {
+    tree.emplace("s" + std::to_string(i) + ":key", "value");
+  }
+  tree.emplace("large", std::string(200 * 1024, 'v'));
+  std::string const expected = write(tree, WritingStyle::Pretty);
+
+  std::FILE* const file = std::tmpfile();
+  ASSERT_NE(nullptr, file);
+  ASSERT_TRUE(Writer(WritingStyle::Pretty).write(tree, fileno(file)));
+
+  std::string contents(expected.size() + 1, '\0');
+  std::rewind(file);
+  contents.resize(std::fread(&contents[0], 1, contents.size(), file));
+  std::fclose(file);
+  EXPECT_EQ(expected, contents);
+}
+
+TEST(WriterTests, can_not_write_to_wrong_file_descriptor)
+{
+  EXPECT_FALSE(Writer().write({ { "a", "1" } }, -1));
+}
@@ -0,0 +1,94 @@
+#include "parser.hxx"
+#include "snapshot.hxx"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+
+using namespace parsing;
+
+namespace {
+
+void printUsage(char const* program)
+{
+  std::cerr << "Usage:\n"
+    << "  " << program << " <source> <snapshot>\n"
+    << "    Parses the source text and writes its snapshot\n"
+    << "  " << program << " --check <source> <snapshot>\n"
+    << "    Checks if the snapshot is valid and made from the source\n";
+}
+
+bool readFile(std::string const& path, std::string& contents)
+{
+  std::ifstream file(path, std::ios::binary);
+  contents.assign(std::istreambuf_iterator<char>(file),
+    std::istreambuf_iterator<char>());
+  return !file.bad() && file.is_open();
+}
+
+int makeSnapshot(std::string const& sourcePath,
+  std::string const& snapshotPath)
+{
+  std::string source;
+  if (!readFile(sourcePath, source)) {
+    std::cerr << "Failed to read '" << sourcePath << "'\n";
+    return 1;
+  }
+
+  Parser parser(source.data(), source.size());
+  Parser::ParsingResult const result = parser.parse();
+  if (!result.m_success) {
+    std::cerr << "Failed to parse '" << sourcePath << "' at line "
+      << result.m_error.m_line << ", column " << result.m_error.m_column
+      << "\n";
+    return 1;
+  }
+
+  uint64_t const sourceHash =
+    Snapshot::hashSource(source.data(), source.size());
+  if (!Snapshot::writeFile(snapshotPath, result.m_tree, sourceHash)) {
+    std::cerr << "Failed to write '" << snapshotPath << "'\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+int checkSnapshot(std::string const& sourcePath,
+  std::string const& snapshotPath)
+{
+  std::string source;
+  if (!readFile(sourcePath, source)) {
+    std::cerr << "Failed to read '" << sourcePath << "'\n";
+    return 1;
+  }
+
+  Snapshot snapshot;
+  if (!snapshot.open(snapshotPath)) {
+    std::cerr << "'" << snapshotPath << "' is not a valid snapshot\n";
+    return 1;
+  }
+
+  if (!snapshot.isMadeFrom(source.data(), source.size())) {
+    std::cerr << "'" << snapshotPath << "' is outdated\n";
+    return 2;
+  }
+
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if ((argc == 4) && (std::string(argv[1]) == "--check")) {
+    return checkSnapshot(argv[2], argv[3]);
+  } else if ((argc == 3) && (argv[1][0] != '-')) {
+    return makeSnapshot(argv[1], argv[2]);
+  }
+
+  printUsage(argv[0]);
+  return 1;
+}